@@ -0,0 +1,146 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "BufferPool.hpp"
+
+template<typename T>
+BufferPool<T>::BufferPool(size_t capacity, size_t bufferSize)
+: m_capacity{capacity}
+, m_bufferSize{bufferSize}
+{
+    m_buffers.reserve(m_capacity);
+    for (size_t i = 0; i < m_capacity; ++i) {
+        auto buffer = std::make_shared<std::vector<T>>();
+        buffer->reserve(m_bufferSize);
+        m_buffers.push_back(buffer);
+    }
+}
+
+template<typename T>
+std::shared_ptr<std::vector<T>>
+BufferPool<T>::acquire(size_t size)
+{
+    // as only the acquiring thread adds users,
+    //   a buffer with just the pool as user stays free while we take it
+    std::shared_ptr<std::vector<T>> buffer;
+    size_t used{};
+    for (auto& pooled : m_buffers) {
+        if (pooled.use_count() > 1) {
+            ++used;
+        }
+        else if (!buffer) {
+            // the last user released it with a release operation, synchronize with that
+            std::atomic_thread_fence(std::memory_order_acquire);
+            buffer = pooled;
+            ++used;
+        }
+    }
+    if (used > m_highWater.load(std::memory_order_relaxed)) {
+        m_highWater.store(used, std::memory_order_relaxed);
+    }
+    if (!buffer) {
+        m_misses.fetch_add(1u, std::memory_order_relaxed);
+        return buffer;
+    }
+    m_hits.fetch_add(1u, std::memory_order_relaxed);
+    buffer->resize(size);   // keeps capacity, so this will not allocate up to bufferSize
+    return buffer;
+}
+
+template<typename T>
+size_t
+BufferPool<T>::getCapacity()
+{
+    return m_capacity;
+}
+
+template<typename T>
+size_t
+BufferPool<T>::getBufferSize()
+{
+    return m_bufferSize;
+}
+
+template<typename T>
+size_t
+BufferPool<T>::getHits()
+{
+    return m_hits.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+size_t
+BufferPool<T>::getMisses()
+{
+    return m_misses.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+size_t
+BufferPool<T>::getHighWater()
+{
+    return m_highWater.load(std::memory_order_relaxed);
+}
+
+// instantiate with the most likely types
+template class BufferPool<int16_t>;
+template class BufferPool<float>;
+
+template<typename T>
+BufferQueue<T>::BufferQueue(size_t capacity)
+: m_slots(capacity)
+{
+}
+
+template<typename T>
+bool
+BufferQueue<T>::push(std::shared_ptr<std::vector<T>>& buffer)
+{
+    const auto tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) >= m_slots.size()) {
+        return false;
+    }
+    m_slots[tail % m_slots.size()] = std::move(buffer);     // the slot was emptied by pop
+    m_tail.store(tail + 1u, std::memory_order_release);
+    return true;
+}
+
+template<typename T>
+std::shared_ptr<std::vector<T>>
+BufferQueue<T>::pop()
+{
+    const auto head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire)) {
+        return {};
+    }
+    auto buffer = std::move(m_slots[head % m_slots.size()]);
+    m_head.store(head + 1u, std::memory_order_release);
+    return buffer;
+}
+
+template<typename T>
+size_t
+BufferQueue<T>::getCapacity()
+{
+    return m_slots.size();
+}
+
+template class BufferQueue<int16_t>;
+template class BufferQueue<float>;
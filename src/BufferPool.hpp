@@ -0,0 +1,81 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4;  coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+
+// a pool of a fixed number of buffers, the buffers are handed out as shared_ptr
+//   and will be reused when all users released them
+//   (e.g. the ChunkedArray that was built from a buffer was analyzed)
+//   this avoids allocations for each chunk of audio data.
+//   All buffers are allocated up front, acquire neither locks nor allocates
+//   (up to bufferSize), so it is usable from the audio thread,
+//   but only from one thread (the one that acquires).
+//   If all buffers are in use a empty pointer is returned (counts as miss).
+template<typename T>
+class BufferPool
+{
+public:
+    BufferPool(size_t capacity, size_t bufferSize);
+    explicit BufferPool(const BufferPool& orig) = delete;
+    virtual ~BufferPool() = default;
+
+    // get a buffer with the given size, the content is not defined
+    std::shared_ptr<std::vector<T>> acquire(size_t size);
+    size_t getCapacity();
+    size_t getBufferSize();
+    size_t getHits();
+    size_t getMisses();
+    // the maximum number of buffers that were used at the same time
+    size_t getHighWater();
+
+private:
+    const size_t m_capacity;
+    const size_t m_bufferSize;
+    std::vector<std::shared_ptr<std::vector<T>>> m_buffers;
+    std::atomic<size_t> m_hits{};
+    std::atomic<size_t> m_misses{};
+    std::atomic<size_t> m_highWater{};
+};
+
+// hands the pool buffers from the audio thread to the reading thread,
+//   a bounded single producer single consumer ring,
+//   the slots are allocated up front so push and pop will not allocate
+template<typename T>
+class BufferQueue
+{
+public:
+    BufferQueue(size_t capacity);
+    explicit BufferQueue(const BufferQueue& orig) = delete;
+    virtual ~BufferQueue() = default;
+
+    // false if the queue is full (the buffer is kept by the caller)
+    bool push(std::shared_ptr<std::vector<T>>& buffer);
+    // a empty pointer if nothing was queued
+    std::shared_ptr<std::vector<T>> pop();
+    size_t getCapacity();
+
+private:
+    std::vector<std::shared_ptr<std::vector<T>>> m_slots;
+    std::atomic<size_t> m_head{};   // next to pop, only written by the consumer
+    std::atomic<size_t> m_tail{};   // next to push, only written by the producer
+};
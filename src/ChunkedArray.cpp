@@ -22,74 +22,151 @@
 #include <string>
 #include <limits>
 #include <stdexcept>
+#include <algorithm>
+#include <bit>
 
 
 #include "ChunkedArray.hpp"
 
 
 template<typename T>
-ChunkedArray<T>::ChunkedArray(uint32_t channels)
+ChunkedArray<T>::ChunkedArray(uint32_t channels, ChunkedStorage storage, size_t capacity)
 : m_channels{channels}
+, m_storage{storage}
 {
+    if (m_storage == ChunkedStorage::Ring) {
+        growRing(std::max(capacity, static_cast<size_t>(1u)));
+    }
+}
+
+template<typename T>
+void
+ChunkedArray<T>::growRing(size_t required)
+{
+    auto capacity = std::bit_ceil(required);   // keep power of two, so we can mask the index
+    std::vector<T> ring;
+    ring.resize(capacity);
+    for (size_t i = 0; i < m_size; ++i) {
+        ring[i] = m_ring[(m_ringHead + i) & m_ringMask];
+    }
+    m_ring = std::move(ring);
+    m_ringMask = capacity - 1;
+    m_ringHead = 0;
 }
 
 template<typename T>
 void
 ChunkedArray<T>::add(const std::shared_ptr<std::vector<T>>& data)
 {
+    add(std::span<const T>(data->data(), data->size()), data);
+}
+
+template<typename T>
+void
+ChunkedArray<T>::add(std::span<const T> data, const std::shared_ptr<const void>& owner)
+{
+    if (data.empty()) {
+        return;     // nothing to index, would create a duplicate key
+    }
+    ++m_statistics.fragments;
+    if (m_storage == ChunkedStorage::Ring) {
+        if (m_size + data.size() > m_ring.size()) {
+            growRing(m_size + data.size());
+        }
+        // copy in at most two parts, before and after the wrap around
+        auto tail = (m_ringHead + m_size) & m_ringMask;
+        auto first = std::min(data.size(), m_ring.size() - tail);
+        std::copy(data.begin(), data.begin() + first, m_ring.begin() + tail);
+        std::copy(data.begin() + first, data.end(), m_ring.begin());
+        m_size += data.size();
+        return;
+    }
+    if (data.size() < m_coalesce) {
+        coalesce(data);
+        return;
+    }
+    m_block.reset();    // keep the order, so the following need a new block
     size_t start{};
     if (!m_data.empty()) {
         auto lastEnty = m_data.rbegin();
         start = lastEnty->first;
-        start += data->size();      // we need only include -1 only once
+        start += data.size();      // we need only include -1 only once
     }
     else {
-        start += data->size() - 1;  // -1 as we want for size to go to next
+        start += data.size() - 1;  // -1 as we want for size to go to next
+    }
+    m_data.insert(std::make_pair(start, Chunk{data, owner}));
+    m_size += data.size();
+}
+
+template<typename T>
+void
+ChunkedArray<T>::coalesce(std::span<const T> data)
+{
+    ++m_statistics.coalesced;
+    while (!data.empty()) {
+        // the block is referenced by us and its chunk, if there are more (copy or slice) start a new one
+        if (!m_block || m_block->size() >= m_coalesce || m_block.use_count() > 2) {
+            m_block = std::make_shared<std::vector<T>>();
+            m_block->reserve(m_coalesce);   // the data must not move, as the chunk references it
+        }
+        auto len = std::min(data.size(), m_coalesce - m_block->size());
+        m_block->insert(m_block->end(), data.begin(), data.begin() + len);
+        if (m_block->size() == len) {   // new block
+            size_t start = m_data.empty()
+                            ? len - 1
+                            : m_data.rbegin()->first + len;
+            m_data.insert(std::make_pair(start, Chunk{std::span<const T>(*m_block), m_block}));
+        }
+        else {
+            // as the key grows, the block stays last, so moving the node is sufficient (no allocation)
+            auto node = m_data.extract(std::prev(m_data.end()));
+            node.key() += len;
+            node.mapped().data = std::span<const T>(*m_block);
+            m_data.insert(std::move(node));
+        }
+        m_size += len;
+        data = data.subspan(len);
     }
-    m_data.insert(std::make_pair(start, data));
-    m_size += data->size();
 }
 
 template<typename T>
 T
 ChunkedArray<T>::operator[] (size_t i) const
 {
-    // the map reduces the runtime from 13s to 0.1s
-    auto low = m_data.lower_bound(i);
-    if (low != m_data.end()) {
-        size_t diff{};
-        if (low != m_data.begin()) {
-            auto prev = low;
-            --prev;
-            diff = prev->first;
-            i -= diff + 1;
+    if (m_storage == ChunkedStorage::Ring) {
+        if (i < m_size) {
+            return m_ring[(m_ringHead + i) & m_ringMask];
         }
-        //std::cout << "i " << i
-        //          << " found low " << low->first
-        //          << " diff " << diff << std::endl;
-        return low->second->operator[] (i);
-    }
-    //high = map.upper_bound(pos);
-
-//    size_t idx{i};
-//    //std::cout << "operator " << i << " of " << m_size << std::endl;
-//    for (auto chunk = m_data.begin(); chunk != m_data.end(); ++chunk) {
-//        auto act = *chunk;
-//        if (idx < act->size()) {
-//            return act->operator[] (idx);
-//        }
-//        idx -= act->size();
-//    }
-    //std::cout << "operator " << i << " beyond end " << m_size << std::endl;
-    //return 0;
+        throw std::runtime_error("reached end of chunked array!");
+    }
+    // the map reduces the runtime from 13s to 0.1s
+    size_t chunkStart{};
+    auto chunk = findChunk(i, chunkStart);
+    if (chunk != m_data.end()) {
+        return chunk->second.data[i - chunkStart];
+    }
     throw std::runtime_error("reached end of chunked array!");
 }
 
+template<typename T>
+typename std::map<size_t, typename ChunkedArray<T>::Chunk>::const_iterator
+ChunkedArray<T>::findChunk(size_t i, size_t& chunkStart) const
+{
+    // the key is the last index of a chunk, so the chunk starts after the previous key
+    auto chunk = m_data.lower_bound(i);
+    chunkStart = 0;
+    if (chunk != m_data.begin()) {
+        chunkStart = std::prev(chunk)->first + 1;
+    }
+    return chunk;
+}
+
 template<typename T>
 bool
 ChunkedArray<T>::empty() const
 {
-    return m_data.empty();
+    return m_size == 0;
 }
 
 template<typename T>
@@ -110,9 +187,110 @@ template<typename T>
 double
 ChunkedArray<T>::getInputScale() const
 {
-    // in practice using normalized input leaves only a very small signal
-    return 1.0 / static_cast<double>(std::numeric_limits<T>::max() / 64);
+    return INPUT_SCALE;
+}
+
+template<typename T>
+ChunkedStorage
+ChunkedArray<T>::getStorage() const
+{
+    return m_storage;
+}
+
+template<typename T>
+size_t
+ChunkedArray<T>::getCapacity() const
+{
+    return m_ring.size();
+}
+
+template<typename T>
+void
+ChunkedArray<T>::drop(size_t count)
+{
+    if (m_storage != ChunkedStorage::Ring) {
+        throw std::runtime_error("drop only supported with ring storage!");
+    }
+    count = std::min(count, m_size);
+    m_ringHead = (m_ringHead + count) & m_ringMask;
+    m_size -= count;
+}
+
+template<typename T>
+size_t
+ChunkedArray<T>::getFrames() const
+{
+    return m_size / m_channels;
+}
+
+template<typename T>
+ChannelView<T>
+ChunkedArray<T>::channel(uint32_t channel) const
+{
+    if (channel >= m_channels) {
+        throw std::runtime_error("channel not available!");
+    }
+    return ChannelView<T>(*this, channel);
+}
+
+template<typename T>
+ChunkedArray<T>
+ChunkedArray<T>::slice(size_t begin, size_t end) const
+{
+    end = std::min(end, m_size);
+    ChunkedArray<T> slice{m_channels};
+    if (begin >= end) {
+        return slice;
+    }
+    if (m_storage == ChunkedStorage::Ring) {
+        auto copy = std::make_shared<std::vector<T>>();
+        copy->reserve(end - begin);
+        for_each_segment(begin, end, [&] (std::span<const T> segment) {
+            copy->insert(copy->end(), segment.begin(), segment.end());
+        });
+        slice.add(copy);
+        return slice;
+    }
+    size_t chunkStart{};
+    auto chunk = findChunk(begin, chunkStart);
+    while (begin < end && chunk != m_data.end()) {
+        const auto& data = chunk->second.data;
+        auto offs = begin - chunkStart;
+        auto len = std::min(data.size() - offs, end - begin);
+        slice.add(data.subspan(offs, len), chunk->second.owner);
+        begin += len;
+        chunkStart = chunk->first + 1;
+        ++chunk;
+    }
+    return slice;
+}
+
+template<typename T>
+void
+ChunkedArray<T>::setCoalesce(size_t minBlock)
+{
+    m_coalesce = minBlock;
+    m_block.reset();
+}
+
+template<typename T>
+size_t
+ChunkedArray<T>::getCoalesce() const
+{
+    return m_coalesce;
+}
+
+template<typename T>
+ChunkStatistics
+ChunkedArray<T>::getStatistics() const
+{
+    ChunkStatistics statistics{m_statistics};
+    statistics.chunks = m_storage == ChunkedStorage::Ring
+                        ? 1u
+                        : m_data.size();
+    return statistics;
 }
 
-// instantiate with the most likely type
+// instantiate with the most likely types
 template class ChunkedArray<int16_t>;
+template class ChunkedArray<float>;
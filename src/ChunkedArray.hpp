@@ -22,29 +22,294 @@
 #include <map>
 #include <memory>
 #include <cstdint>
+#include <span>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <limits>
 
 
+template<typename T>
+class ChannelView;
+
+// compile time conversion of the sample types to the analysis input level
+//   in practice using normalized input leaves only a very small signal,
+//   for that reason full scale is 64 (as established with int16 input)
+template<typename T>
+struct SampleTraits;
+
+template<>
+struct SampleTraits<int16_t>
+{
+    static constexpr double inputScale{1.0 / static_cast<double>(std::numeric_limits<int16_t>::max() / 64)};
+};
+
+template<>
+struct SampleTraits<float>
+{
+    // float is already normalized to -1..1, keep the same level as int16
+    static constexpr double inputScale{static_cast<double>(std::numeric_limits<int16_t>::max()) * SampleTraits<int16_t>::inputScale};
+};
+
+// the effect of coalescing, the fragments as added and the resulting chunks
+struct ChunkStatistics
+{
+    size_t fragments{};
+    size_t chunks{};
+    size_t coalesced{};     // fragments that were copied into a block
+};
+
+enum class ChunkedStorage
+{
+      Chunked   // keep the chunks as delivered, index lookup by map
+    , Ring      // copy into a power of two ring buffer, index lookup by mask
+};
+
 // a implementation of a array with chunked storage
 //   this allows storage as data is provided by a audio interface (in chunks)
 //   and avoids creating a flat copy, for the price of computation time
+// alternatively the ring storage spends one copy on add,
+//   but makes the access a mask and a load
+// with multiple channels the samples are kept interleaved (as delivered),
+//   size and indexes are by sample, use the frame/channel functions
+//   to access a single channel
 template<typename T>
 class ChunkedArray
 {
 public:
-    ChunkedArray(uint32_t channels);
+    ChunkedArray(uint32_t channels, ChunkedStorage storage = ChunkedStorage::Chunked, size_t capacity = 0);
     ChunkedArray(const ChunkedArray& orig) = default;
     virtual ~ChunkedArray() = default;
 
     void add(const std::shared_ptr<std::vector<T>>& data);
+    // add data that is kept valid by owner (e.g. a mapped file),
+    //   with ring storage it will be copied
+    void add(std::span<const T> data, const std::shared_ptr<const void>& owner);
     T operator[] (size_t i) const;
     bool empty() const;
     size_t size() const;
     uint32_t getChannels() const;
-    double getInputScale() const; // use this to normalize input to -1..1
+    double getInputScale() const; // use this to normalize input (see SampleTraits)
+    static constexpr double INPUT_SCALE{SampleTraits<T>::inputScale};
+    ChunkedStorage getStorage() const;
+    // for ring storage the allocated samples (grows if required)
+    size_t getCapacity() const;
+    // remove the oldest samples, the following are moved down by count
+    //   (only supported with ring storage)
+    void drop(size_t count);
+    // call fn with the contiguous parts (as std::span<const T>) that cover [begin, end)
+    //   use this for block operations instead of accessing each sample by index
+    template<typename Fn>
+    void for_each_segment(size_t begin, size_t end, Fn&& fn) const;
+    // copy count samples starting at pos to dst multiplied by scale,
+    //   if the array ends before, the remaining values are zero filled
+    // @return the number of samples copied from the array
+    template<typename D>
+    size_t copy_window(size_t pos, size_t count, D* dst, D scale) const;
+    // number of complete frames (one sample for each channel)
+    size_t getFrames() const;
+    // same as copy_window but for a single channel, pos and count are frames
+    template<typename D>
+    size_t copy_channel(size_t pos, size_t count, uint32_t channel, D* dst, D scale) const;
+    // for stereo: mid = (left + right) / 2, side = (left - right) / 2,
+    //   pos and count are frames, side may be nullptr if not needed
+    template<typename D>
+    size_t downmix_mid_side(size_t pos, size_t count, D* mid, D* side, D scale) const;
+    // a view to a single channel, without copying
+    ChannelView<T> channel(uint32_t channel) const;
+    // a array with the samples [begin, end) that shares the chunks with this,
+    //   for multiple channels keep begin and end at frame boundaries.
+    //   As the ring storage will be overwritten, it requires a copy.
+    ChunkedArray<T> slice(size_t begin, size_t end) const;
+    // merge fragments smaller than minBlock into blocks of minBlock samples
+    //   (for chunked storage, fragments that were added before are not changed)
+    //   use 0 to add each fragment as chunk (default)
+    void setCoalesce(size_t minBlock);
+    size_t getCoalesce() const;
+    ChunkStatistics getStatistics() const;
+protected:
+    void coalesce(std::span<const T> data);
+    void growRing(size_t required);
+    struct Chunk
+    {
+        std::span<const T> data;
+        std::shared_ptr<const void> owner;  // keeps data valid
+    };
+    // find the chunk containing index i, chunkStart is set to the index of the first sample of it
+    typename std::map<size_t, Chunk>::const_iterator findChunk(size_t i, size_t& chunkStart) const;
 private:
     uint32_t m_channels;
+    ChunkedStorage m_storage;
     size_t m_size{};
-    std::map<size_t, std::shared_ptr<std::vector<T>>> m_data;
+    std::map<size_t, Chunk> m_data;
+    size_t m_coalesce{};
+    std::shared_ptr<std::vector<T>> m_block;    // the last chunk, if it is a block that is not full
+    ChunkStatistics m_statistics;
+    std::vector<T> m_ring;
+    size_t m_ringMask{};
+    size_t m_ringHead{};
+};
+
+template<typename T>
+template<typename Fn>
+void
+ChunkedArray<T>::for_each_segment(size_t begin, size_t end, Fn&& fn) const
+{
+    end = std::min(end, m_size);
+    if (begin >= end) {
+        return;
+    }
+    if (m_storage == ChunkedStorage::Ring) {
+        auto start = (m_ringHead + begin) & m_ringMask;
+        auto count = end - begin;
+        auto first = std::min(count, m_ring.size() - start);
+        fn(std::span<const T>(m_ring.data() + start, first));
+        if (first < count) {    // wrapped around
+            fn(std::span<const T>(m_ring.data(), count - first));
+        }
+        return;
+    }
+    size_t chunkStart{};
+    auto chunk = findChunk(begin, chunkStart);
+    while (begin < end && chunk != m_data.end()) {
+        const auto& data = chunk->second.data;
+        auto offs = begin - chunkStart;
+        auto len = std::min(data.size() - offs, end - begin);
+        fn(std::span<const T>(data.data() + offs, len));
+        begin += len;
+        chunkStart = chunk->first + 1;
+        ++chunk;
+    }
+}
+
+template<typename T>
+template<typename D>
+size_t
+ChunkedArray<T>::copy_window(size_t pos, size_t count, D* dst, D scale) const
+{
+    size_t copied{};
+    for_each_segment(pos, pos + count, [&] (std::span<const T> segment) {
+        D* out = dst + copied;
+        for (size_t i = 0; i < segment.size(); ++i) {
+            out[i] = static_cast<D>(segment[i]) * scale;
+        }
+        copied += segment.size();
+    });
+    std::fill(dst + copied, dst + count, D{});
+    return copied;
+}
+
+template<typename T>
+template<typename D>
+size_t
+ChunkedArray<T>::copy_channel(size_t pos, size_t count, uint32_t channel, D* dst, D scale) const
+{
+    if (m_channels == 1) {
+        return copy_window(pos, count, dst, scale);
+    }
+    const size_t stride{m_channels};
+    size_t index{pos * stride};     // sample index of the segment start
+    size_t copied{};
+    const size_t end = std::min(pos + count, getFrames()) * stride;   // only complete frames
+    for_each_segment(index, end, [&] (std::span<const T> segment) {
+        // segments need not to start with a frame
+        size_t i = (channel + stride - index % stride) % stride;
+        D* out = dst + copied;
+        size_t n{};
+        for (; i < segment.size(); i += stride, ++n) {
+            out[n] = static_cast<D>(segment[i]) * scale;
+        }
+        copied += n;
+        index += segment.size();
+    });
+    std::fill(dst + copied, dst + count, D{});
+    return copied;
+}
+
+template<typename T>
+template<typename D>
+size_t
+ChunkedArray<T>::downmix_mid_side(size_t pos, size_t count, D* mid, D* side, D scale) const
+{
+    if (m_channels != 2) {
+        throw std::runtime_error("mid/side requires stereo!");
+    }
+    const D half = scale * static_cast<D>(0.5);
+    size_t index{pos * 2};
+    size_t copied{};
+    D carry{};      // a left sample if a frame is split between chunks
+    for_each_segment(index, (pos + count) * 2, [&] (std::span<const T> segment) {
+        size_t i{};
+        if (index % 2 == 1 && !segment.empty()) {
+            D left = carry;
+            D right = static_cast<D>(segment[0]);
+            mid[copied] = (left + right) * half;
+            if (side) {
+                side[copied] = (left - right) * half;
+            }
+            ++copied;
+            i = 1;
+        }
+        // the split loops allow the compiler to vectorize
+        const size_t frames = (segment.size() - i) / 2;
+        const T* in = segment.data() + i;
+        D* outMid = mid + copied;
+        for (size_t n = 0; n < frames; ++n) {
+            outMid[n] = (static_cast<D>(in[2 * n]) + static_cast<D>(in[2 * n + 1])) * half;
+        }
+        if (side) {
+            D* outSide = side + copied;
+            for (size_t n = 0; n < frames; ++n) {
+                outSide[n] = (static_cast<D>(in[2 * n]) - static_cast<D>(in[2 * n + 1])) * half;
+            }
+        }
+        copied += frames;
+        if ((segment.size() - i) % 2 == 1) {
+            carry = static_cast<D>(segment.back());
+        }
+        index += segment.size();
+    });
+    std::fill(mid + copied, mid + count, D{});
+    if (side) {
+        std::fill(side + copied, side + count, D{});
+    }
+    return copied;
+}
+
+// a single channel of a ChunkedArray, indexes are frames
+//   keep the array alive as long as the view is used
+template<typename T>
+class ChannelView
+{
+public:
+    ChannelView(const ChunkedArray<T>& array, uint32_t channel)
+    : m_array{array}
+    , m_channel{channel}
+    {
+    }
+    ChannelView(const ChannelView& orig) = default;
+    virtual ~ChannelView() = default;
+
+    T operator[] (size_t i) const
+    {
+        return m_array[i * m_array.getChannels() + m_channel];
+    }
+    size_t size() const
+    {
+        return m_array.getFrames();
+    }
+    uint32_t getChannel() const
+    {
+        return m_channel;
+    }
+    template<typename D>
+    size_t copy_window(size_t pos, size_t count, D* dst, D scale) const
+    {
+        return m_array.copy_channel(pos, count, m_channel, dst, scale);
+    }
+private:
+    const ChunkedArray<T>& m_array;
+    const uint32_t m_channel;
 };
 
 //
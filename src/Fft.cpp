@@ -21,57 +21,67 @@
 #include <cmath>
 #include <limits>
 #include <algorithm>
-
+#include <cstdlib>  // getenv
+#include <chrono>
+#include <bit>      // bit_ceil
 
 #include "Fft.hpp"
+#include "SpectrumKernel.hpp"
 #include "glscene_config.h"
 
-template <uint32_t windowSize>
-std::vector<size_t>
-Spectrum<windowSize>::m_lookup;
 
-template <uint32_t windowSize>
-Spectrum<windowSize>::Spectrum()
+template <typename P>
+SpectrumBase<P>::SpectrumBase(uint32_t windowSize)
+: m_windowSize{windowSize}
 {
     m_sum.resize(windowSize / 2 + 1);  // fixed relationship, the remaining bins are mirrored
-    std::ranges::fill(m_sum, 0.0);
+    std::ranges::fill(m_sum, P{});
 }
 
 
-template <uint32_t windowSize>
+template <typename P>
 void
-Spectrum<windowSize>::setAddScale(double addScale)
+SpectrumBase<P>::setAddScale(double addScale)
 {
     m_addScale = addScale;
 }
 
 
-template <uint32_t windowSize>
+template <typename P>
 void
-Spectrum<windowSize>::add(fftw_complex* fft_result)
+SpectrumBase<P>::add(typename FftwApi<P>::complex* fft_result)
 {
     // Copy the first (windowSize/2 + 1) data points into your spectrogram.
     // We do this because the FFT output is mirrored about the nyquist
     // frequency, so the second half of the data is redundant.
     // include a first correction with the factor we know, so the sum will not grow too fast
+    //   the mirrored bins count twice, except the nyquist
+    const size_t bins = m_sum.size();
+    const auto scale = m_addScale / static_cast<double>(m_windowSize);
+    const P* values = &fft_result[0][FftEngine<P>::REAL];
+    SpectrumKernel<P>::accumulate(values, m_sum.data(), bins - 1u, static_cast<P>(2.0 * scale));
+    SpectrumKernel<P>::accumulate(values + 2u * (bins - 1u), m_sum.data() + bins - 1u, 1u, static_cast<P>(scale));
+}
+
+template <typename P>
+void
+SpectrumBase<P>::reset()
+{
+    std::ranges::fill(m_sum, P{});
+}
+
+template <typename P>
+void
+SpectrumBase<P>::add(const SpectrumBase& other)
+{
     for (size_t i = 0; i < m_sum.size(); i++) {
-        auto abs = std::sqrt(fft_result[i][Fft<windowSize>::REAL] * fft_result[i][Fft<windowSize>::REAL] + fft_result[i][Fft<windowSize>::IMAG] * fft_result[i][Fft<windowSize>::IMAG]);
-        auto scale = m_addScale;
-        if (i < m_sum.size() -1) {
-            scale *= 2.0;
-        }
-        //if (i >= 11 && i <= 14) {
-        //    std::cout << "add " << i
-        //              << " abs " << abs
-        //              << " scale " << scale << std::endl;
-        //}
-        m_sum[i] += abs * scale / static_cast<double>(windowSize);      // keep double as long as possible
+        m_sum[i] += other.m_sum[i];
     }
 }
 
-template <uint32_t windowSize>
+template <typename P>
 void
-Spectrum<windowSize>::scale(double nScale)
+SpectrumBase<P>::scale(double nScale)
 {
 #   ifdef DEBUG
     std::cout << "Spectrum::scale"
@@ -79,70 +89,234 @@ Spectrum<windowSize>::scale(double nScale)
               << " by " << nScale << std::endl;
 #   endif
     for (size_t i = 0; i < m_sum.size(); i++) {
-        m_sum[i] *= nScale;
+        m_sum[i] *= static_cast<P>(nScale);
     }
 }
 
-template <uint32_t windowSize>
+template <typename P>
 double
-Spectrum<windowSize>::getMax()
+SpectrumBase<P>::getMax()
 {
     //double max{std::numeric_limits<double>::lowest()};
     //for (size_t i = 0; i < m_sum.size(); i++) {
     //    max = std::max(max, m_sum[i]);
     //}
     //return max;
-    return std::ranges::max(m_sum);
+    return static_cast<double>(std::ranges::max(m_sum));
+}
+
+
+std::mutex SpectrumMapping::m_mutex;
+std::map<SpectrumMapping::Key, std::shared_ptr<const std::vector<uint32_t>>> SpectrumMapping::m_mappings;
+
+std::shared_ptr<const std::vector<uint32_t>>
+SpectrumMapping::get(size_t bins, size_t cnt, double usageFactor, SpectrumScale scale)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto key = std::tuple(bins, cnt, usageFactor, scale);
+    auto entry = m_mappings.find(key);
+    if (entry != m_mappings.end()) {
+        return entry->second;
+    }
+    if (m_mappings.size() >= MAX_MAPPINGS) {
+        m_mappings.clear();     // these are cheap to build, keep it simple
+    }
+    auto mapping = std::make_shared<const std::vector<uint32_t>>(create(bins, cnt, usageFactor, scale));
+    m_mappings.insert(std::pair(key, mapping));
+    return mapping;
+}
+
+template <typename P>
+std::map<std::tuple<size_t, size_t, double, double, SpectrumScale>, std::shared_ptr<const SpectrumFilterbank<P>>>&
+SpectrumMapping::getFilterbanks()
+{
+    static std::map<std::tuple<size_t, size_t, double, double, SpectrumScale>, std::shared_ptr<const SpectrumFilterbank<P>>> filterbanks;  // by precision
+    return filterbanks;
+}
+
+template <typename P>
+std::shared_ptr<const SpectrumFilterbank<P>>
+SpectrumMapping::getFilterbank(size_t bins, size_t cnt, double rate, double usageFactor, SpectrumScale scale)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto& filterbanks = getFilterbanks<P>();
+    auto key = std::tuple(bins, cnt, rate, usageFactor, scale);
+    auto entry = filterbanks.find(key);
+    if (entry != filterbanks.end()) {
+        return entry->second;
+    }
+    if (filterbanks.size() >= MAX_MAPPINGS) {
+        filterbanks.clear();
+    }
+    auto filterbank = std::make_shared<const SpectrumFilterbank<P>>(bins, cnt, rate, usageFactor, scale);
+    filterbanks.insert(std::pair(key, filterbank));
+    return filterbank;
+}
+
+void
+SpectrumMapping::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_mappings.clear();
+    getFilterbanks<double>().clear();
+    getFilterbanks<float>().clear();
+}
+
+double
+SpectrumMapping::toScale(double hz, SpectrumScale scale)
+{
+    switch (scale) {
+    case SpectrumScale::Bark:
+        return 26.81 * hz / (1960.0 + hz) - 0.53;
+    case SpectrumScale::Mel:
+        return 2595.0 * std::log10(1.0 + hz / 700.0);
+    default:
+        return hz;
+    }
+}
+
+double
+SpectrumMapping::fromScale(double value, SpectrumScale scale)
+{
+    switch (scale) {
+    case SpectrumScale::Bark:
+        return 1960.0 * (value + 0.53) / (26.28 - value);
+    case SpectrumScale::Mel:
+        return 700.0 * (std::pow(10.0, value / 2595.0) - 1.0);
+    default:
+        return value;
+    }
+}
+
+// need template instantiation
+template std::shared_ptr<const SpectrumFilterbank<double>> SpectrumMapping::getFilterbank<double>(size_t bins, size_t cnt, double rate, double usageFactor, SpectrumScale scale);
+template std::shared_ptr<const SpectrumFilterbank<float>> SpectrumMapping::getFilterbank<float>(size_t bins, size_t cnt, double rate, double usageFactor, SpectrumScale scale);
+
+template <typename P>
+SpectrumFilterbank<P>::SpectrumFilterbank(size_t bins, size_t cnt, double rate, double usageFactor, SpectrumScale scale)
+{
+    m_first.reserve(cnt);
+    m_offsets.reserve(cnt + 1u);
+    m_norm.reserve(cnt);
+    m_offsets.push_back(0u);
+    const double hzPerBin = rate / 2.0 / static_cast<double>(bins - 1u);
+    const double lower = SpectrumMapping::toScale(0.0, scale);
+    const double upper = SpectrumMapping::toScale(usageFactor * rate / 2.0, scale);
+    const double step = (upper - lower) / static_cast<double>(cnt + 1u);
+    for (size_t n = 0; n < cnt; ++n) {
+        // the filter rises from the previous center to its center and falls to the next
+        const double left = SpectrumMapping::fromScale(lower + step * static_cast<double>(n), scale);
+        const double center = SpectrumMapping::fromScale(lower + step * static_cast<double>(n + 1u), scale);
+        const double right = SpectrumMapping::fromScale(lower + step * static_cast<double>(n + 2u), scale);
+        auto first = static_cast<size_t>(std::floor(left / hzPerBin)) + 1u;
+        auto last = std::min(static_cast<size_t>(std::ceil(right / hzPerBin)), bins);     // exclusive
+        double sum{};
+        for (size_t k = first; k < last; ++k) {
+            const double hz = static_cast<double>(k) * hzPerBin;
+            const double weight = hz <= center
+                                ? (hz - left) / (center - left)
+                                : (right - hz) / (right - center);
+            m_weights.push_back(static_cast<P>(std::max(weight, 0.0)));
+            sum += std::max(weight, 0.0);
+        }
+        if (sum <= 0.0) {
+            // narrower than a bin (the lower filters of a small fft), use the nearest
+            m_weights.resize(m_offsets.back());
+            first = std::min(static_cast<size_t>(std::lround(center / hzPerBin)), bins - 1u);
+            m_weights.push_back(P{1});
+            sum = 1.0;
+        }
+        m_first.push_back(static_cast<uint32_t>(first));
+        m_offsets.push_back(static_cast<uint32_t>(m_weights.size()));
+        m_norm.push_back(static_cast<P>(1.0 / sum));
+    }
+}
+
+template <typename P>
+void
+SpectrumFilterbank<P>::apply(const std::vector<P>& sum, std::vector<float>& fout, double factor, bool keepSum) const
+{
+    const size_t cnt = m_first.size();
+    fout.resize(cnt);
+    for (size_t n = 0; n < cnt; ++n) {
+        const auto len = m_offsets[n + 1u] - m_offsets[n];
+        auto value = SpectrumKernel<P>::dot(m_weights.data() + m_offsets[n], sum.data() + m_first[n], len);
+        if (!keepSum) {
+            value *= m_norm[n];
+        }
+        fout[n] = static_cast<float>(static_cast<double>(value) * factor);
+    }
+}
+
+template <typename P>
+size_t
+SpectrumFilterbank<P>::getCount() const
+{
+    return m_first.size();
+}
+
+template <typename P>
+uint32_t
+SpectrumFilterbank<P>::getFirst(size_t n) const
+{
+    return m_first[n];
+}
+
+template <typename P>
+std::span<const P>
+SpectrumFilterbank<P>::getWeights(size_t n) const
+{
+    return std::span<const P>(m_weights.data() + m_offsets[n], m_offsets[n + 1u] - m_offsets[n]);
 }
 
+// need template instantiation
+template class SpectrumFilterbank<double>;
+template class SpectrumFilterbank<float>;
+
+std::vector<uint32_t>
+SpectrumMapping::create(size_t bins, size_t cnt, double usageFactor, SpectrumScale scale)
+{
+    const size_t sumSize = static_cast<size_t>(static_cast<double>(bins) * usageFactor);
+    std::vector<uint32_t> bounds(cnt + 1u, 0u);
+    if (cnt == 0u) {
+        return bounds;
+    }
+    const double factorLin = static_cast<double>(cnt) / static_cast<double>(sumSize);
+    const double factorLog = (10.0 - 1.0) / static_cast<double>(sumSize);
+    // the tile is ascending with the bin, so count the bins for each tile
+    //   and make these the bounds
+    for (size_t i = 0; i < sumSize; ++i) {
+        size_t n = scale == SpectrumScale::Logarithmic
+                 ? static_cast<size_t>(std::log10(1.0 + static_cast<double>(i) * factorLog) * static_cast<double>(cnt))
+                 : static_cast<size_t>(static_cast<double>(i) * factorLin);
+        ++bounds[std::min(n, cnt - 1u) + 1u];
+    }
+    for (size_t n = 1; n < bounds.size(); ++n) {
+        bounds[n] += bounds[n - 1u];
+    }
+    return bounds;
+}
 
 /*
  * with a linear adjustment ~ the frequencies upto ~2k go into the lowest bin
  *   which is not intuitive
  */
-template <uint32_t windowSize>
+template <typename P>
 std::vector<float>
-Spectrum<windowSize>::adjustLin(size_t cnt, double usageFactor, double factor, bool keepSum)
+SpectrumBase<P>::adjustLin(size_t cnt, double usageFactor, double factor, bool keepSum)
 {
     std::vector<float> fout;
-    fout.resize(cnt);
-    std::ranges::fill(fout, 0.0f);
-    const size_t sumSize = static_cast<size_t>(static_cast<double>(m_sum.size()) * usageFactor);
-    double factorLin = static_cast<double>(cnt) / static_cast<double>(sumSize);
-    std::vector<size_t> binCnt;
-    binCnt.resize(cnt);
-    std::ranges::fill(binCnt, 0);
-    double maxIn{std::numeric_limits<double>::lowest()};
-    for (size_t i = 0; i < sumSize; ++i) {
-        auto n = static_cast<size_t>(static_cast<double>(i) * factorLin);
-        fout[n] += static_cast<float>(m_sum[i] * factor);
-        ++binCnt[n];
-        maxIn = std::max(maxIn, m_sum[i]);
-    }
-    if (maxIn < 0.0001) {
-        return fout;        // don't scale silence
-    }
-    float maxOut{std::numeric_limits<float>::min()};
-    for (size_t n = 0; n < fout.size(); ++n) {
-        if (!keepSum) {
-            fout[n] /= static_cast<float>(binCnt[n]);
-        }
-        maxOut = std::max(maxOut, fout[n]);
-    }
-    //auto scale = static_cast<float>(maxVal) / maxOut;
-    //for (size_t i = 0; i < fout.size(); ++i) {
-    //    fout[i] *= scale;
-    //}
-#   ifdef DEBUG
-    std::cout << "Spectrum::adjustLin"
-              << " usageFactor " << usageFactor
-              << " factor " << factorLin
-              << " maxIn " << maxIn
-              << " maxOut " << maxOut << std::endl;
-#   endif
+    adjustLin(fout, cnt, usageFactor, factor, keepSum);
     return fout;
 }
 
+template <typename P>
+void
+SpectrumBase<P>::adjustLin(std::vector<float>& fout, size_t cnt, double usageFactor, double factor, bool keepSum)
+{
+    auto mapping = SpectrumMapping::get(m_sum.size(), cnt, usageFactor, SpectrumScale::Linear);
+    gather(fout, *mapping, factor, keepSum, false);
+}
 
 /**
  * @param cnt number of resulting "bins"
@@ -151,58 +325,74 @@ Spectrum<windowSize>::adjustLin(size_t cnt, double usageFactor, double factor, b
  *         which usually is not the region of interest.
  * @return a vector with adjusted bins
  */
-template <uint32_t windowSize>
+template <typename P>
 std::vector<float>
-Spectrum<windowSize>::adjustLog(size_t cnt, double usageFactor, double factor, bool keepSum)
+SpectrumBase<P>::adjustLog(size_t cnt, double usageFactor, double factor, bool keepSum)
 {
     std::vector<float> fout;
-    fout.resize(cnt);
-    std::ranges::fill(fout, 0.0f);
-    const size_t sumSize = static_cast<size_t>(static_cast<double>(m_sum.size()) * usageFactor);
-    double factorLog = (10.0 - 1.0) / static_cast<double>(sumSize);
-    std::vector<size_t> binCnt;
-    binCnt.resize(cnt);
-    std::ranges::fill(binCnt, 0);
+    adjustLog(fout, cnt, usageFactor, factor, keepSum);
+    return fout;
+}
+
+template <typename P>
+void
+SpectrumBase<P>::adjustLog(std::vector<float>& fout, size_t cnt, double usageFactor, double factor, bool keepSum)
+{
+    auto mapping = SpectrumMapping::get(m_sum.size(), cnt, usageFactor, SpectrumScale::Logarithmic);
+    gather(fout, *mapping, factor, keepSum, true);
+}
+
+template <typename P>
+void
+SpectrumBase<P>::adjustFilterbank(std::vector<float>& fout, size_t cnt, double usageFactor, double rate, SpectrumScale scale, double factor, bool keepSum)
+{
+    auto filterbank = SpectrumMapping::getFilterbank<P>(m_sum.size(), cnt, rate, usageFactor, scale);
+    filterbank->apply(m_sum, fout, factor, keepSum);
+}
+
+template <typename P>
+void
+SpectrumBase<P>::gather(std::vector<float>& fout, const std::vector<uint32_t>& bounds, double factor, bool keepSum, bool useMax)
+{
+    const size_t cnt = bounds.size() - 1u;
+    fout.resize(cnt);      // keeps the capacity if reused
     double maxIn{std::numeric_limits<double>::lowest()};
-    for (size_t i = 0; i < sumSize; ++i) {
-        auto n = std::min(static_cast<size_t>(std::log10(1.0 + static_cast<double>(i) * factorLog) * static_cast<double>(cnt)), static_cast<size_t>(cnt-1));
-        fout[n] = std::max(fout[n], static_cast<float>(m_sum[i] * factor));
-        ++binCnt[n];
-        maxIn = std::max(maxIn, m_sum[i]);
+    for (size_t n = 0; n < cnt; ++n) {
+        float value{};
+        for (size_t i = bounds[n]; i < bounds[n + 1u]; ++i) {
+            auto scaled = static_cast<float>(m_sum[i] * factor);
+            value = useMax ? std::max(value, scaled) : value + scaled;
+            maxIn = std::max(maxIn, static_cast<double>(m_sum[i]));
+        }
+        fout[n] = value;
     }
     if (maxIn < 0.0001) {
 #       ifdef DEBUG
-        std::cout << "Spectrum::adjustLog silence " << maxIn << std::endl;
+        std::cout << "Spectrum::gather silence " << maxIn << std::endl;
 #       endif
-        return fout;        // dont scale silence up
+        return;             // dont scale silence up
     }
     float maxOut{std::numeric_limits<float>::min()};
-    for (size_t n = 0; n < fout.size(); ++n) {
-        if (!keepSum) {
-            fout[n] /= static_cast<float>(binCnt[n]);
+    for (size_t n = 0; n < cnt; ++n) {
+        const auto bins = bounds[n + 1u] - bounds[n];
+        if (!keepSum
+         && bins > 0u) {    // a tile may get no bin with a small fft
+            fout[n] /= static_cast<float>(bins);
         }
         maxOut = std::max(maxOut, fout[n]);
     }
-    //auto scale = static_cast<float>(maxVal) / maxOut;
-    //for (size_t i = 0; i < fout.size(); ++i) {
-    //    fout[i] *= scale;
-    //}
 #   ifdef DEBUG
-    std::cout << "Spectrum::adjustLog"
-              << " usageFactor " << usageFactor
-              << " factor log " << factorLog
+    std::cout << "Spectrum::gather"
+              << " max " << useMax
               << " maxIn " << maxIn
               << " maxOut " << maxOut << std::endl;
 #   endif
-    return fout;
 }
 
-
-
 // need template instantiation
-template class Spectrum<2048u>;
+template class SpectrumBase<double>;
 
-template class Spectrum<512u>;
+template class SpectrumBase<float>;
 
 SignalGenerator::SignalGenerator()
 : m_scale{static_cast<float>(std::numeric_limits<int16_t>::max())}
@@ -286,157 +476,1397 @@ SquareSignal::generate(size_t samples, float period)
 
 
 
-template <uint32_t windowSize>
-Fft<windowSize>::Fft(const std::shared_ptr<WindowFunction<windowSize>>& windowFunction)
-: m_windowFunction{windowFunction}
-{
-    m_fft_input = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * windowSize);
-    m_fft_result = (fftw_complex*) fftw_malloc(sizeof(fftw_complex) * windowSize);
-    m_plan_forward = fftw_plan_dft_1d(windowSize, m_fft_input, m_fft_result, FFTW_FORWARD, FFTW_ESTIMATE);
-    // others use e.g. https://github.com/GatzeTech/Qt-FFTW/blob/main/mainwindow.cpp
-    //mFftIn  = fftw_alloc_real(NUM_SAMPLES);
-    //mFftOut = fftw_alloc_real(NUM_SAMPLES);
-    //mFftPlan = fftw_plan_r2r_1d(NUM_SAMPLES, mFftIn, mFftOut, FFTW_R2HC,FFTW_MEASURE);
+std::mutex FftPlanner::m_mutex;
+std::mutex FftPlanner::m_cacheMutex;
+FftPlanning FftPlanner::m_planning{FftPlanning::Estimate};
 
+FftPlanning
+FftPlanner::getPlanning()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_planning;
 }
 
-template <uint32_t windowSize>
-Fft<windowSize>::~Fft()
+void
+FftPlanner::setPlanning(FftPlanning planning)
 {
-    fftw_destroy_plan(m_plan_forward);
-    if (m_fft_input) {
-        fftw_free(m_fft_input);
-        m_fft_input = nullptr;
-    }
-    if (m_fft_result) {
-        fftw_free(m_fft_result);
-        m_fft_result = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_planning == planning) {
+            return;
+        }
+        m_planning = planning;
     }
+    clearSetups();
 }
 
-template <uint32_t windowSize>
-std::shared_ptr<Spectrum<windowSize>>
-Fft<windowSize>::execute(const ChunkedArray<int16_t>& in)
+void
+FftPlanner::clearSetups()
 {
-    auto spectrum = std::make_shared<Spectrum<windowSize>>();
-    if (in.empty()) {
-        return spectrum;
+    std::map<uint32_t, std::shared_ptr<const FftSetup<double>>> setups;
+    std::map<uint32_t, std::shared_ptr<const FftSetup<float>>> setupsf;
+    {
+        std::lock_guard<std::mutex> lock(m_cacheMutex);
+        setups.swap(getCache<double>().setups);
+        setupsf.swap(getCache<float>().setups);
     }
-    if (in.getChannels() != 1) {
-        throw std::runtime_error("fft only prepared for a single channel!");
+    // the plans are released outside the cache lock, destroy needs the planner lock
+}
+
+template <typename P>
+FftPlanner::Cache<P>&
+FftPlanner::getCache()
+{
+    static Cache<P> cache;
+    return cache;
+}
+
+template <typename P>
+std::shared_ptr<const FftSetup<P>>
+FftPlanner::getSetup(uint32_t windowSize)
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    auto& setups = getCache<P>().setups;
+    auto entry = setups.find(windowSize);
+    if (entry != setups.end()) {
+        return entry->second;
     }
+    auto setup = std::make_shared<const FftSetup<P>>(windowSize);
+    setups.insert(std::pair(windowSize, setup));
+    return setup;
+}
 
-    // see https://ofdsp.blogspot.com/2011/08/short-time-fourier-transform-with-fftw3.html
-    // more on windowing https://download.ni.com/evaluation/pxi/Understanding%20FFTs%20and%20Windowing.pdf
-    size_t chunkPosition{};
-    bool bStopReadChunks{false};
-    size_t numChunks{};
-    // https://dsp.stackexchange.com/questions/63001/why-should-i-scale-the-fft-using-1-n
-    //auto nScale = 1.0 / std::sqrt(static_cast<double>(windowSize));
-                         //  * static_cast<double>(std::numeric_limits<int16_t>::max()));      // since we want output not depend on on used input (and here it's simpler to apply than on input with the same result)
+template <typename P>
+std::shared_ptr<const std::vector<P>>
+FftPlanner::getWindow(FftWindowType windowType, uint32_t windowSize)
+{
+    std::lock_guard<std::mutex> lock(m_cacheMutex);
+    auto& windows = getCache<P>().windows;
+    auto key = std::pair(windowType, windowSize);
+    auto entry = windows.find(key);
+    if (entry != windows.end()) {
+        return entry->second;
+    }
+    auto window = std::make_shared<const std::vector<P>>(FftWindows::create<P>(windowType, windowSize));
+    windows.insert(std::pair(key, window));
+    return window;
+}
 
-    spectrum->setAddScale(m_scale);    // * nScale
-    // Process each chunk of the signal
-    const auto inputScale = in.getInputScale();
-    uint32_t filled{};
-    double maxIn1{std::numeric_limits<double>::lowest()};
-    [[maybe_unused]]
-    double maxIn2{std::numeric_limits<double>::lowest()};
-    // only use the parts that are fully usable, to avoid the uncertainty when padding (-> try to stabilize the output levels)
-    while (chunkPosition < in.size() - windowSize - 1 && !bStopReadChunks) {   // use only complete windows (inaccurate, waters down max values)
-        // Copy the chunk into our buffer
-        for (size_t i = 0; i < windowSize; i++) {
-            size_t readIndex = chunkPosition + i;
-            if (readIndex < in.size()) {    // signal
-                auto v = static_cast<double>(in[readIndex] * inputScale);  // signal
-                maxIn1 = std::max(maxIn1, v);
-                auto w = v * m_windowFunction->windowing(i);
-                maxIn2 = std::max(maxIn2, w);
-                m_fft_input[i][REAL] = w;
-                m_fft_input[i][IMAG] = 0.0;
-            }
-            else {
-                // we have read beyond the signal, so zero-pad it!
-                m_fft_input[i][REAL] = 0.0;
-                m_fft_input[i][IMAG] = 0.0;
-                bStopReadChunks = true;
-                ++filled;
-            }
+template <typename P>
+std::vector<P>
+FftWindows::create(FftWindowType window, uint32_t windowSize)
+{
+    // same as the compile time tables of PolicyWindow but for any size
+    return visit(window, [windowSize] (auto policy) {
+        std::vector<P> values(windowSize);
+        for (size_t i = 0; i < windowSize; ++i) {
+            values[i] = static_cast<P>(decltype(policy)::value(i, windowSize));
         }
-        // Perform the FFT on our chunk
-        fftw_execute(m_plan_forward);
-        spectrum->add(m_fft_result);
-        chunkPosition += m_hopSize;
-        numChunks++;
-    }
-    auto chunkScale = 1.0 / (static_cast<double>(numChunks));   // undo effect of sliding window (reduce by windowing)
-    //chunkScale *= m_scale;
-    spectrum->scale(chunkScale);
-#   ifdef DEBUG
-    std::cout << "Fft::execute"
-            //  << " min freq (4 cd) " << 44100/windowSize << "Hz"
-              << " set scale " << m_scale
-              << " maxIn1 " << maxIn1
-              << " maxIn2 " << maxIn2
-              << " filled " << filled
-              << " chunks " << numChunks << std::endl;
-#   endif
-    return spectrum;
+        return values;
+    });
 }
 
-template <uint32_t windowSize>
 double
-Fft<windowSize>::calibrate(double to)
+FftWindows::getAmplitudeCorrection(FftWindowType window)
 {
-    setScale(1.0);
-    SinusSignal sig;
-    ChunkedArray<int16_t> in = sig.generate(8000, 44100.0f/1000.0f);    // ~ 1kHz for Cd
-    auto spec = execute(in);
-    double factor = to / spec->getMax();
-#   ifdef DEBUG
-    std::cout << "Fft::calibrate"
-              << " max " << spec->getMax()
-              << " to " << to
-              << " resulting factor " << factor << std::endl;
-#   endif
-    setScale(factor);
-    return getScale();
+    return visit(window, [] (auto policy) {
+        return decltype(policy)::AMPLITUDE_CORRECTION;
+    });
 }
 
-template <uint32_t windowSize>
 double
-Fft<windowSize>::getScale()
+FftWindows::getEnergyCorrection(FftWindowType window)
 {
-    return m_scale;
+    return visit(window, [] (auto policy) {
+        return decltype(policy)::ENERGY_CORRECTION;
+    });
+}
+
+std::string
+FftWindows::toId(FftWindowType window)
+{
+    switch (window) {
+    case FftWindowType::Hann:
+        return WINDOW_HANN;
+    case FftWindowType::BlackmanHarris:
+        return WINDOW_BLACKMAN_HARRIS;
+    case FftWindowType::FlatTop:
+        return WINDOW_FLAT_TOP;
+    case FftWindowType::Kaiser:
+        return WINDOW_KAISER;
+    default:
+        return WINDOW_HAMMING;
+    }
+}
+
+FftWindowType
+FftWindows::fromId(const std::string& id)
+{
+    if (id == WINDOW_HANN) {
+        return FftWindowType::Hann;
+    }
+    if (id == WINDOW_BLACKMAN_HARRIS) {
+        return FftWindowType::BlackmanHarris;
+    }
+    if (id == WINDOW_FLAT_TOP) {
+        return FftWindowType::FlatTop;
+    }
+    if (id == WINDOW_KAISER) {
+        return FftWindowType::Kaiser;
+    }
+    return FftWindowType::Hamming;
+}
+
+// need template instantiation
+template std::vector<double> FftWindows::create<double>(FftWindowType window, uint32_t windowSize);
+template std::vector<float> FftWindows::create<float>(FftWindowType window, uint32_t windowSize);
+
+std::string
+FftPlanner::toId(FftPlanning planning)
+{
+    switch (planning) {
+    case FftPlanning::Measure:
+        return PLANNING_MEASURE;
+    case FftPlanning::Patient:
+        return PLANNING_PATIENT;
+    default:
+        return PLANNING_ESTIMATE;
+    }
+}
+
+FftPlanning
+FftPlanner::fromId(const std::string& id)
+{
+    if (id == PLANNING_MEASURE) {
+        return FftPlanning::Measure;
+    }
+    if (id == PLANNING_PATIENT) {
+        return FftPlanning::Patient;
+    }
+    return FftPlanning::Estimate;
 }
 
-template <uint32_t windowSize>
+unsigned
+FftPlanner::getFlags()
+{
+    switch (m_planning) {
+    case FftPlanning::Measure:
+        return FFTW_MEASURE;
+    case FftPlanning::Patient:
+        return FFTW_PATIENT;
+    default:
+        return FFTW_ESTIMATE;
+    }
+}
+
+// @return the wisdom file, empty if no usable cache dir was found
+template <typename P>
+std::filesystem::path
+FftPlanner::getWisdomFile()
+{
+    std::filesystem::path cache;
+    if (auto xdgCache = std::getenv("XDG_CACHE_HOME"); xdgCache && *xdgCache) {
+        cache = xdgCache;
+    }
+    else if (auto home = std::getenv("HOME"); home && *home) {
+        cache = std::filesystem::path(home) / ".cache";
+    }
+    else if (auto localAppData = std::getenv("LOCALAPPDATA"); localAppData && *localAppData) {
+        cache = localAppData;   // windows
+    }
+    else {
+        return cache;
+    }
+    return cache / PACKAGE / FftwApi<P>::WISDOM_FILE;
+}
+
+template <typename P>
 void
-Fft<windowSize>::setScale(double scale)
+FftPlanner::loadWisdom()
 {
-    m_scale = scale;
+    static bool wisdomLoaded{false};      // by precision
+    if (wisdomLoaded) {
+        return;
+    }
+    wisdomLoaded = true;
+    initThreads<P>();   // fftw requires this before any other planning
+    auto file = getWisdomFile<P>();
+    std::error_code ec;
+    if (file.empty() || !std::filesystem::exists(file, ec)) {
+        return;
+    }
+    if (!FftwApi<P>::import_wisdom_from_filename(file.string().c_str())) {
+        std::cout << "FftPlanner::loadWisdom unusable wisdom " << file << std::endl;
+    }
 }
 
-template <uint32_t windowSize>
-uint32_t
-Fft<windowSize>::getHopSize()
+template <typename P>
+bool
+FftPlanner::initThreads()
 {
-    return m_hopSize;
+#   ifdef HAVE_FFTW_THREADS
+    static const bool threadsUsable{FftwApi<P>::init_threads() != 0};   // by precision
+#       ifdef DEBUG
+    if (!threadsUsable) {
+        std::cout << "FftPlanner::initThreads fftw threads not usable" << std::endl;
+    }
+#       endif
+    return threadsUsable;
+#   else
+    return false;
+#   endif
 }
 
-template <uint32_t windowSize>
+template <typename P>
 void
-Fft<windowSize>::setHopSize(uint32_t hopSize)
+FftPlanner::saveWisdom()
 {
-    m_hopSize = hopSize;
+    auto file = getWisdomFile<P>();
+    if (file.empty()) {
+        return;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(file.parent_path(), ec);
+    // write to a temporary and rename, so a concurrent start never sees a partial file
+    auto tmp = file;
+    tmp += ".tmp";
+    if (!ec
+     && FftwApi<P>::export_wisdom_to_filename(tmp.string().c_str())) {
+        std::filesystem::rename(tmp, file, ec);
+    }
+    if (ec) {
+        std::cout << "FftPlanner::saveWisdom error " << ec.message() << " saving " << file << std::endl;
+    }
+}
+
+template <typename P, typename F>
+typename FftwApi<P>::plan
+FftPlanner::plan(int n, F&& planner)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    loadWisdom<P>();
+    auto flags = getFlags();
+    if (flags == FFTW_ESTIMATE) {
+        return planner(flags);
+    }
+    // only plan with the requested effort if the wisdom doesn't know the answer yet
+    //   (measuring overwrites the buffers, they are filled before each execute anyway)
+    auto plan = planner(flags | FFTW_WISDOM_ONLY);
+    if (!plan) {
+#       ifdef DEBUG
+        auto start = std::chrono::steady_clock::now();
+#       endif
+        plan = planner(flags);
+#       ifdef DEBUG
+        auto end = std::chrono::steady_clock::now();
+        std::cout << "FftPlanner::plan"
+                  << " size " << n
+                  << " planning " << toId(m_planning)
+                  << " took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << "ms" << std::endl;
+#       endif
+        saveWisdom<P>();
+    }
+    return plan;
+}
+
+template <typename P>
+typename FftwApi<P>::plan
+FftPlanner::planR2c(int n, P* in, typename FftwApi<P>::complex* out)
+{
+    return plan<P>(n, [&] (unsigned flags) {
+        return FftwApi<P>::plan_dft_r2c_1d(n, in, out, flags);
+    });
+}
+
+template <typename P>
+typename FftwApi<P>::plan
+FftPlanner::planManyR2c(int n, int howmany, P* in, int idist, typename FftwApi<P>::complex* out, int odist)
+{
+    return plan<P>(n, [&] (unsigned flags) {
+        return FftwApi<P>::plan_many_dft_r2c(n, howmany, in, idist, out, odist, flags);
+    });
+}
+
+template <typename P>
+typename FftwApi<P>::plan
+FftPlanner::planThreadedR2c(int n, int threads, P* in, typename FftwApi<P>::complex* out)
+{
+    return plan<P>(n, [&] (unsigned flags) {
+        if (!initThreads<P>()) {
+            return FftwApi<P>::plan_dft_r2c_1d(n, in, out, flags);  // stays on the calling thread
+        }
+        FftwApi<P>::plan_with_nthreads(threads);
+        auto plan = FftwApi<P>::plan_dft_r2c_1d(n, in, out, flags);
+        FftwApi<P>::plan_with_nthreads(1);
+        return plan;
+    });
+}
+
+template <typename P>
+void
+FftPlanner::destroy(typename FftwApi<P>::plan plan)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    FftwApi<P>::destroy_plan(plan);
 }
 
 // need template instantiation
-template class Fft<2048u>;
+template std::filesystem::path FftPlanner::getWisdomFile<double>();
+template fftw_plan FftPlanner::planR2c<double>(int n, double* in, fftw_complex* out);
+template fftw_plan FftPlanner::planManyR2c<double>(int n, int howmany, double* in, int idist, fftw_complex* out, int odist);
+template fftw_plan FftPlanner::planThreadedR2c<double>(int n, int threads, double* in, fftw_complex* out);
+template void FftPlanner::destroy<double>(fftw_plan plan);
 
-// maybe audacious is right, avoid the lowest frequencies,
-// as for modern music these are most prominent
-template class Fft<512u>;
+template std::filesystem::path FftPlanner::getWisdomFile<float>();
+template fftwf_plan FftPlanner::planR2c<float>(int n, float* in, fftwf_complex* out);
+template fftwf_plan FftPlanner::planManyR2c<float>(int n, int howmany, float* in, int idist, fftwf_complex* out, int odist);
+template fftwf_plan FftPlanner::planThreadedR2c<float>(int n, int threads, float* in, fftwf_complex* out);
+template void FftPlanner::destroy<float>(fftwf_plan plan);
+template std::shared_ptr<const FftSetup<double>> FftPlanner::getSetup<double>(uint32_t windowSize);
+template std::shared_ptr<const FftSetup<float>> FftPlanner::getSetup<float>(uint32_t windowSize);
+template std::shared_ptr<const std::vector<double>> FftPlanner::getWindow<double>(FftWindowType windowType, uint32_t windowSize);
+template std::shared_ptr<const std::vector<float>> FftPlanner::getWindow<float>(FftWindowType windowType, uint32_t windowSize);
 
-// only 4 testing
-template class Fft<256u>;
+template <typename P>
+FftSetup<P>::FftSetup(uint32_t windowSize)
+: m_windowSize{windowSize}
+{
+    if (windowSize == 0u) {
+        throw std::runtime_error("fft window size 0 not usable!");
+    }
+    // plan on temporary buffers, the engines use their own with the same alignment
+    //   and strides (see FftBuffers), so any slot can be passed to the plans.
+    //   As the input is real, use the real to complex transform,
+    //   this computes only the non redundant half (windowSize / 2 + 1 bins)
+    //   that is used by Spectrum::add anyway
+    auto inputStride = getInputStride(windowSize);
+    auto resultStride = getResultStride(windowSize);
+    auto input = FftwApi<P>::alloc_real(static_cast<size_t>(BATCH_WINDOWS) * inputStride);
+    auto result = FftwApi<P>::alloc_complex(static_cast<size_t>(BATCH_WINDOWS) * resultStride);
+    m_plan = FftPlanner::planR2c<P>(static_cast<int>(windowSize), input, result);
+    m_batchPlan = FftPlanner::planManyR2c<P>(static_cast<int>(windowSize), BATCH_WINDOWS, input, static_cast<int>(inputStride), result, static_cast<int>(resultStride));
+    FftwApi<P>::free(input);
+    FftwApi<P>::free(result);
+    if (!m_plan || !m_batchPlan) {
+        if (m_plan) {
+            FftPlanner::destroy<P>(m_plan);
+        }
+        if (m_batchPlan) {
+            FftPlanner::destroy<P>(m_batchPlan);
+        }
+        throw std::runtime_error("fft no plan for size " + std::to_string(windowSize));
+    }
+}
+
+template <typename P>
+FftSetup<P>::~FftSetup()
+{
+    if (m_plan) {
+        FftPlanner::destroy<P>(m_plan);
+    }
+    if (m_batchPlan) {
+        FftPlanner::destroy<P>(m_batchPlan);
+    }
+}
+
+template <typename P>
+uint32_t
+FftSetup<P>::getWindowSize() const
+{
+    return m_windowSize;
+}
+
+template <typename P>
+typename FftwApi<P>::plan
+FftSetup<P>::getPlan() const
+{
+    return m_plan;
+}
+
+template <typename P>
+typename FftwApi<P>::plan
+FftSetup<P>::getBatchPlan() const
+{
+    return m_batchPlan;
+}
+
+// need template instantiation
+template class FftSetup<double>;
+
+template class FftSetup<float>;
+
+template <typename P>
+FftBuffers<P>::FftBuffers(uint32_t windowSize)
+: m_inputStride{FftSetup<P>::getInputStride(windowSize)}
+, m_resultStride{FftSetup<P>::getResultStride(windowSize)}
+{
+    m_input = FftwApi<P>::alloc_real(static_cast<size_t>(FftSetup<P>::BATCH_WINDOWS) * m_inputStride);
+    m_result = FftwApi<P>::alloc_complex(static_cast<size_t>(FftSetup<P>::BATCH_WINDOWS) * m_resultStride);
+}
+
+template <typename P>
+FftBuffers<P>::~FftBuffers()
+{
+    if (m_input) {
+        FftwApi<P>::free(m_input);
+        m_input = nullptr;
+    }
+    if (m_result) {
+        FftwApi<P>::free(m_result);
+        m_result = nullptr;
+    }
+}
+
+template <typename P>
+P*
+FftBuffers<P>::getInput(uint32_t slot)
+{
+    return m_input + static_cast<size_t>(slot) * m_inputStride;
+}
+
+template <typename P>
+typename FftwApi<P>::complex*
+FftBuffers<P>::getResult(uint32_t slot)
+{
+    return m_result + static_cast<size_t>(slot) * m_resultStride;
+}
+
+// need template instantiation
+template class FftBuffers<double>;
+
+template class FftBuffers<float>;
+
+template <typename P>
+FftEngine<P>::FftEngine(uint32_t windowSize, uint32_t hopSize, FftWindowType window)
+: m_windowSize{windowSize}
+, m_hopSize{hopSize > 0u ? hopSize : windowSize}
+, m_setup{FftPlanner::getSetup<P>(windowSize)}
+, m_window{FftPlanner::getWindow<P>(window, windowSize)}
+, m_buffers{windowSize}
+, m_amplitudeCorrection{FftWindows::getAmplitudeCorrection(window)}
+, m_energyCorrection{FftWindows::getEnergyCorrection(window)}
+{
+}
+
+template <typename P>
+FftEngine<P>::FftEngine(uint32_t windowSize, const std::shared_ptr<const std::vector<P>>& window, double amplitudeCorrection, double energyCorrection)
+: m_windowSize{windowSize}
+, m_hopSize{windowSize}
+, m_setup{FftPlanner::getSetup<P>(windowSize)}
+, m_window{window}
+, m_buffers{windowSize}
+, m_amplitudeCorrection{amplitudeCorrection}
+, m_energyCorrection{energyCorrection}
+{
+}
+
+template <typename P>
+FftEngine<P>::~FftEngine()
+{
+}
+
+template <typename P>
+std::shared_ptr<SpectrumBase<P>>
+FftEngine<P>::execute(const ChunkedArray<int16_t>& in, uint32_t channel)
+{
+    auto spectrum = std::make_shared<SpectrumBase<P>>(m_windowSize);
+    executeSamples(in, channel, *spectrum);
+    return spectrum;
+}
+
+template <typename P>
+std::shared_ptr<SpectrumBase<P>>
+FftEngine<P>::execute(const ChunkedArray<float>& in, uint32_t channel)
+{
+    auto spectrum = std::make_shared<SpectrumBase<P>>(m_windowSize);
+    executeSamples(in, channel, *spectrum);
+    return spectrum;
+}
+
+template <typename P>
+void
+FftEngine<P>::execute(const ChunkedArray<int16_t>& in, SpectrumBase<P>& out, uint32_t channel)
+{
+    if (out.getWindowSize() != m_windowSize) {
+        throw std::runtime_error("fft spectrum size does not match!");
+    }
+    out.reset();
+    executeSamples(in, channel, out);
+}
+
+template <typename P>
+void
+FftEngine<P>::execute(const ChunkedArray<float>& in, SpectrumBase<P>& out, uint32_t channel)
+{
+    if (out.getWindowSize() != m_windowSize) {
+        throw std::runtime_error("fft spectrum size does not match!");
+    }
+    out.reset();
+    executeSamples(in, channel, out);
+}
+
+template <typename P>
+template <typename T>
+void
+FftEngine<P>::executeSamples(const ChunkedArray<T>& in, uint32_t channel, SpectrumBase<P>& spectrum)
+{
+    if (in.empty()) {
+        return;
+    }
+    if (channel != CHANNEL_MID && channel >= in.getChannels()) {
+        throw std::runtime_error("fft channel not available!");
+    }
+
+    // see https://ofdsp.blogspot.com/2011/08/short-time-fourier-transform-with-fftw3.html
+    // more on windowing https://download.ni.com/evaluation/pxi/Understanding%20FFTs%20and%20Windowing.pdf
+    size_t chunkPosition{};
+    bool bStopReadChunks{false};
+    size_t numChunks{};
+    // https://dsp.stackexchange.com/questions/63001/why-should-i-scale-the-fft-using-1-n
+    //auto nScale = 1.0 / std::sqrt(static_cast<double>(windowSize));
+                         //  * static_cast<double>(std::numeric_limits<int16_t>::max()));      // since we want output not depend on on used input (and here it's simpler to apply than on input with the same result)
+
+    // as the fft is linear, apply the input scale to the result,
+    //   this leaves only the conversion to double for each sample
+    spectrum.setAddScale(getAddScale(ChunkedArray<T>::INPUT_SCALE));    // * nScale
+    // Process each chunk of the signal
+    uint32_t filled{};
+    const uint32_t batchWindows{getBatchWindows()};
+    const auto windowSize = m_windowSize;
+    // only use the parts that are fully usable, to avoid the uncertainty when padding (-> try to stabilize the output levels)
+    const auto frames = in.getFrames();
+    auto threads = m_threads > 0u
+                 ? m_threads
+                 : std::max(std::thread::hardware_concurrency(), 1u);
+    if (threads > 1u && frames > windowSize + 1u) {
+        // as there is no padding for these, count the windows ahead to split them up
+        size_t windows = (frames - windowSize - 1u + m_hopSize - 1u) / m_hopSize;
+        threads = static_cast<uint32_t>(std::min(static_cast<size_t>(threads), windows / WINDOWS_PER_THREAD));
+        if (threads > 1u) {
+            executeParallel(in, channel, windows, threads, spectrum);
+            spectrum.scale(1.0 / static_cast<double>(windows));
+            return;
+        }
+    }
+    while (chunkPosition < frames - windowSize - 1 && !bStopReadChunks) {   // use only complete windows (inaccurate, waters down max values)
+        uint32_t windows{};
+        while (windows < batchWindows
+            && chunkPosition < frames - windowSize - 1
+            && !bStopReadChunks) {
+            auto copied = fillWindow(in, chunkPosition, channel, m_buffers, windows);
+            if (copied < windowSize) {
+                filled += static_cast<uint32_t>(windowSize - copied);
+                bStopReadChunks = true;
+            }
+            chunkPosition += m_hopSize;
+            ++windows;
+            numChunks++;
+        }
+        transform(m_buffers, windows);
+        for (uint32_t w = 0; w < windows; ++w) {
+            spectrum.add(m_buffers.getResult(w));
+        }
+    }
+    auto chunkScale = 1.0 / (static_cast<double>(numChunks));   // undo effect of sliding window (reduce by windowing)
+    //chunkScale *= m_scale;
+    spectrum.scale(chunkScale);
+#   ifdef DEBUG
+    std::cout << "Fft::execute"
+              << " size " << windowSize
+              << " set scale " << m_scale
+              << " filled " << filled
+              << " chunks " << numChunks << std::endl;
+#   endif
+}
+
+template <typename P>
+template <typename T>
+void
+FftEngine<P>::executeWindows(const ChunkedArray<T>& in, uint32_t channel, size_t first, size_t last, FftBuffers<P>& buffers, SpectrumBase<P>& spectrum)
+{
+    const uint32_t batchWindows{getBatchWindows()};
+    size_t next{first};
+    while (next < last) {
+        uint32_t windows{};
+        while (windows < batchWindows
+            && next < last) {
+            fillWindow(in, next * m_hopSize, channel, buffers, windows);
+            ++windows;
+            ++next;
+        }
+        transform(buffers, windows);
+        for (uint32_t w = 0; w < windows; ++w) {
+            spectrum.add(buffers.getResult(w));
+        }
+    }
+}
+
+template <typename P>
+template <typename T>
+void
+FftEngine<P>::executeParallel(const ChunkedArray<T>& in, uint32_t channel, size_t windows, uint32_t threads, SpectrumBase<P>& spectrum)
+{
+    // each thread sums up a consecutive range of windows,
+    //   the partial sums are added in order, so the result only depends on the thread count
+    std::vector<std::unique_ptr<SpectrumBase<P>>> partials;
+    std::vector<std::thread> workers;
+    for (uint32_t t = 0; t < threads; ++t) {
+        auto partial = std::make_unique<SpectrumBase<P>>(m_windowSize);
+        partial->setAddScale(getAddScale(ChunkedArray<T>::INPUT_SCALE));
+        size_t first = windows * t / threads;
+        size_t last = windows * (t + 1u) / threads;
+        workers.emplace_back([this, &in, channel, first, last, spectrum = partial.get()] {
+            FftBuffers<P> buffers{m_windowSize};
+            executeWindows(in, channel, first, last, buffers, *spectrum);
+        });
+        partials.push_back(std::move(partial));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    for (auto& partial : partials) {
+        spectrum.add(*partial);
+    }
+#   ifdef DEBUG
+    std::cout << "Fft::executeParallel"
+              << " size " << m_windowSize
+              << " threads " << threads
+              << " windows " << windows << std::endl;
+#   endif
+}
+
+template <typename P>
+template <typename T>
+size_t
+FftEngine<P>::fillWindow(const ChunkedArray<T>& in, size_t pos, uint32_t channel, FftBuffers<P>& buffers, uint32_t slot)
+{
+    // Copy the chunk into our buffer, if we read beyond the signal it gets zero-padded
+    auto window = buffers.getInput(slot);
+    auto copied = channel == CHANNEL_MID
+                ? in.downmix_mid_side(pos, m_windowSize, window, static_cast<P*>(nullptr), P{1})
+                : in.copy_channel(pos, m_windowSize, channel, window, P{1});
+    const P* windowValues = m_window->data();
+    for (size_t i = 0; i < m_windowSize; i++) {
+        window[i] *= windowValues[i];
+    }
+    return copied;
+}
+
+template <typename P>
+void
+FftEngine<P>::transform(FftBuffers<P>& buffers, uint32_t windows)
+{
+    // Perform the FFT on our chunks, a incomplete batch is done one by one
+    if (windows == BATCH_WINDOWS) {
+        FftwApi<P>::execute_dft_r2c(m_setup->getBatchPlan(), buffers.getInput(), buffers.getResult());
+    }
+    else {
+        for (uint32_t w = 0; w < windows; ++w) {
+            FftwApi<P>::execute_dft_r2c(m_setup->getPlan(), buffers.getInput(w), buffers.getResult(w));
+        }
+    }
+}
+
+template <typename P>
+FftBuffers<P>&
+FftEngine<P>::getBuffers()
+{
+    return m_buffers;
+}
+
+template <typename P>
+uint32_t
+FftEngine<P>::getBatchWindows()
+{
+    return m_batched ? BATCH_WINDOWS : 1u;
+}
+
+template <typename P>
+double
+FftEngine<P>::calibrate(double to)
+{
+    setScale(1.0);
+    SinusSignal sig;
+    ChunkedArray<int16_t> in = sig.generate(8000, 44100.0f/1000.0f);    // ~ 1kHz for Cd
+    auto spec = execute(in);
+    double factor = to / spec->getMax();
+#   ifdef DEBUG
+    std::cout << "Fft::calibrate"
+              << " max " << spec->getMax()
+              << " to " << to
+              << " resulting factor " << factor << std::endl;
+#   endif
+    setScale(factor);
+    return getScale();
+}
+
+template <typename P>
+double
+FftEngine<P>::getScale()
+{
+    return m_scale;
+}
+
+template <typename P>
+void
+FftEngine<P>::setScale(double scale)
+{
+    m_scale = scale;
+}
+
+template <typename P>
+double
+FftEngine<P>::getAmplitudeCorrection()
+{
+    return m_amplitudeCorrection;
+}
+
+template <typename P>
+double
+FftEngine<P>::getEnergyCorrection()
+{
+    return m_energyCorrection;
+}
+
+template <typename P>
+double
+FftEngine<P>::getAddScale(double inputScale)
+{
+    return m_scale * inputScale * HammingPolicy::AMPLITUDE_CORRECTION / m_amplitudeCorrection;
+}
+
+template <typename P>
+uint32_t
+FftEngine<P>::getWindowSize()
+{
+    return m_windowSize;
+}
+
+template <typename P>
+uint32_t
+FftEngine<P>::getBins()
+{
+    return FftSetup<P>::getBins(m_windowSize);
+}
+
+template <typename P>
+uint32_t
+FftEngine<P>::getHopSize()
+{
+    return m_hopSize;
+}
+
+template <typename P>
+void
+FftEngine<P>::setHopSize(uint32_t hopSize)
+{
+    m_hopSize = hopSize;
+}
+
+template <typename P>
+uint32_t
+FftEngine<P>::getThreads()
+{
+    return m_threads;
+}
+
+template <typename P>
+void
+FftEngine<P>::setThreads(uint32_t threads)
+{
+    m_threads = threads;
+}
+
+template <typename P>
+bool
+FftEngine<P>::isBatched()
+{
+    return m_batched;
+}
+
+template <typename P>
+void
+FftEngine<P>::setBatched(bool batched)
+{
+    m_batched = batched;
+}
+
+// need template instantiation
+template class FftEngine<double>;
+
+template class FftEngine<float>;
+
+template <typename T, typename P>
+FftStream<T, P>::FftStream(uint32_t channels, uint32_t windowSize, uint32_t hopSize, FftWindowType window)
+: FftEngine<P>{windowSize, hopSize, window}
+, m_pending{channels, ChunkedStorage::Ring, static_cast<size_t>(windowSize) * channels * 2u}
+, m_frame{std::make_shared<SpectrumBase<P>>(windowSize)}
+{
+}
+
+template <typename T, typename P>
+std::shared_ptr<SpectrumBase<P>>
+FftStream<T, P>::push(const ChunkedArray<T>& data, uint32_t channel)
+{
+    auto spectrum = std::make_shared<SpectrumBase<P>>(this->getWindowSize());
+    if (push(data, *spectrum, channel)) {
+        return spectrum;
+    }
+    return nullptr;
+}
+
+template <typename T, typename P>
+bool
+FftStream<T, P>::push(const ChunkedArray<T>& data, SpectrumBase<P>& out, uint32_t channel)
+{
+    const auto channels = m_pending.getChannels();
+    if (data.getChannels() != channels) {
+        throw std::runtime_error("fft stream channels changed!");
+    }
+    if (channel != FftEngine<P>::CHANNEL_MID && channel >= channels) {
+        throw std::runtime_error("fft channel not available!");
+    }
+    const auto windowSize = this->getWindowSize();
+    if (out.getWindowSize() != windowSize) {
+        throw std::runtime_error("fft spectrum size does not match!");
+    }
+    data.for_each_segment(0, data.size(), [this] (std::span<const T> segment) {
+        m_pending.add(segment, nullptr);
+    });
+    if (m_skip > 0) {
+        auto skip = std::min(m_skip, m_pending.getFrames());
+        m_pending.drop(skip * channels);
+        m_skip -= skip;
+    }
+    const auto hopSize = this->getHopSize();
+    const auto batchWindows = this->getBatchWindows();
+    const auto addScale = this->getAddScale(ChunkedArray<T>::INPUT_SCALE);
+    m_frame->setAddScale(addScale);
+    const auto frames = m_pending.getFrames();
+    size_t pos{};
+    size_t windows{};
+    while (pos + windowSize <= frames) {
+        uint32_t slots{};
+        while (slots < batchWindows
+            && pos + windowSize <= frames) {
+            this->fillWindow(m_pending, pos, channel, this->getBuffers(), slots);
+            pos += hopSize;
+            ++slots;
+        }
+        this->transform(this->getBuffers(), slots);
+        if (windows == 0u) {
+            out.reset();        // keep the previous values until there are new ones
+            out.setAddScale(addScale);
+        }
+        for (uint32_t w = 0; w < slots; ++w) {
+            auto result = this->getBuffers().getResult(w);
+            out.add(result);
+            if (m_frameListener) {
+                m_frame->reset();
+                m_frame->add(result);
+                m_frameListener(*m_frame);
+            }
+        }
+        windows += slots;
+    }
+    // keep the samples from the next window on
+    auto consumed = std::min(pos, frames);
+    m_pending.drop(consumed * channels);
+    m_skip += pos - consumed;
+    m_windows += windows;
+    if (windows > 0u) {
+        out.scale(1.0 / static_cast<double>(windows));
+    }
+#   ifdef DEBUG
+    std::cout << "FftStream::push"
+              << " frames " << frames
+              << " windows " << windows
+              << " pending " << m_pending.getFrames() << std::endl;
+#   endif
+    return windows > 0u;
+}
+
+template <typename T, typename P>
+void
+FftStream<T, P>::setFrameListener(const FrameListener& frameListener)
+{
+    m_frameListener = frameListener;
+}
+
+template <typename T, typename P>
+void
+FftStream<T, P>::reset()
+{
+    m_pending.drop(m_pending.size());
+    m_skip = 0;
+    m_windows = 0;
+}
+
+template <typename T, typename P>
+size_t
+FftStream<T, P>::getPending()
+{
+    return m_pending.getFrames();
+}
+
+template <typename T, typename P>
+uint64_t
+FftStream<T, P>::getWindows()
+{
+    return m_windows;
+}
+
+// need template instantiation
+template class FftStream<int16_t, double>;
+
+template class FftStream<int16_t, float>;
+
+template class FftStream<float, double>;
+
+template class FftStream<float, float>;
+
+template <typename P>
+FftSnapshot<P>::FftSnapshot(uint32_t size, uint32_t threads, FftWindowType window)
+: m_size{size}
+, m_threads{threads > 0u ? threads : std::max(std::thread::hardware_concurrency(), 1u)}
+, m_window{FftPlanner::getWindow<P>(window, size)}
+, m_windowGain{HammingPolicy::AMPLITUDE_CORRECTION / FftWindows::getAmplitudeCorrection(window)}
+{
+    if (size < 2u) {
+        throw std::runtime_error("FftSnapshot size " + std::to_string(size) + " not usable");
+    }
+    m_input = FftwApi<P>::alloc_real(size);
+    m_result = FftwApi<P>::alloc_complex(getBins());
+    // planning may overwrite the buffers, they are filled before each execute
+    m_plan = FftPlanner::planThreadedR2c<P>(static_cast<int>(size), static_cast<int>(m_threads), m_input, m_result);
+    if (!m_plan) {
+        FftwApi<P>::free(m_input);
+        FftwApi<P>::free(m_result);
+        throw std::runtime_error("FftSnapshot no plan for size " + std::to_string(size));
+    }
+    m_magnitudes.resize(getBins());
+}
+
+template <typename P>
+FftSnapshot<P>::~FftSnapshot()
+{
+    FftPlanner::destroy<P>(m_plan);
+    FftwApi<P>::free(m_input);
+    FftwApi<P>::free(m_result);
+}
+
+template <typename P>
+const std::vector<P>&
+FftSnapshot<P>::execute(const ChunkedArray<int16_t>& in, uint32_t channel)
+{
+    executeSamples(in, channel);
+    return m_magnitudes;
+}
+
+template <typename P>
+const std::vector<P>&
+FftSnapshot<P>::execute(const ChunkedArray<float>& in, uint32_t channel)
+{
+    executeSamples(in, channel);
+    return m_magnitudes;
+}
+
+template <typename P>
+template <typename T>
+void
+FftSnapshot<P>::executeSamples(const ChunkedArray<T>& in, uint32_t channel)
+{
+    // use the most recent frames
+    const auto frames = in.getFrames();
+    const size_t pos = frames > m_size ? frames - m_size : 0u;
+    if (channel == FftEngine<P>::CHANNEL_MID) {
+        in.downmix_mid_side(pos, m_size, m_input, static_cast<P*>(nullptr), P{1});
+    }
+    else {
+        in.copy_channel(pos, m_size, channel, m_input, P{1});
+    }
+    const P* windowValues = m_window->data();
+    for (size_t i = 0; i < m_size; ++i) {
+        m_input[i] *= windowValues[i];
+    }
+#   ifdef DEBUG
+    auto start = std::chrono::steady_clock::now();
+#   endif
+    FftwApi<P>::execute(m_plan);
+#   ifdef DEBUG
+    auto end = std::chrono::steady_clock::now();
+    std::cout << "FftSnapshot::execute"
+              << " size " << m_size
+              << " threads " << m_threads
+              << " took " << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() << "us" << std::endl;
+#   endif
+    // same scaling as SpectrumBase::add for a single window
+    const auto scale = static_cast<P>(m_scale * m_windowGain * ChunkedArray<T>::INPUT_SCALE / static_cast<double>(m_size));
+    const size_t bins = m_magnitudes.size();
+    for (size_t i = 0; i < bins; ++i) {
+        auto abs = std::sqrt(m_result[i][FftEngine<P>::REAL] * m_result[i][FftEngine<P>::REAL] + m_result[i][FftEngine<P>::IMAG] * m_result[i][FftEngine<P>::IMAG]);
+        m_magnitudes[i] = abs * (i < bins - 1u ? P{2} * scale : scale);
+    }
+}
+
+template <typename P>
+const std::vector<P>&
+FftSnapshot<P>::getMagnitudes()
+{
+    return m_magnitudes;
+}
+
+template <typename P>
+std::vector<P>
+FftSnapshot<P>::decimate(uint32_t displayBins, uint32_t first, uint32_t last)
+{
+    if (last == 0u || last > getBins()) {
+        last = getBins();
+    }
+    std::vector<P> display(displayBins, P{});
+    if (first >= last || displayBins == 0u) {
+        return display;
+    }
+    const size_t range = last - first;
+    for (size_t d = 0; d < displayBins; ++d) {
+        // each display bin gets at least one source bin, if zoomed in they repeat
+        size_t begin = first + range * d / displayBins;
+        size_t end = std::max(first + range * (d + 1u) / displayBins, begin + 1u);
+        display[d] = *std::max_element(m_magnitudes.begin() + begin, m_magnitudes.begin() + end);
+    }
+    return display;
+}
+
+template <typename P>
+double
+FftSnapshot<P>::getBinWidth(double rate)
+{
+    return rate / static_cast<double>(m_size);
+}
+
+template <typename P>
+uint32_t
+FftSnapshot<P>::getSize()
+{
+    return m_size;
+}
+
+template <typename P>
+uint32_t
+FftSnapshot<P>::getBins()
+{
+    return m_size / 2u + 1u;
+}
+
+template <typename P>
+uint32_t
+FftSnapshot<P>::getThreads()
+{
+    return m_threads;
+}
+
+template <typename P>
+double
+FftSnapshot<P>::getScale()
+{
+    return m_scale;
+}
+
+template <typename P>
+void
+FftSnapshot<P>::setScale(double scale)
+{
+    m_scale = scale;
+}
+
+// need template instantiation
+template class FftSnapshot<double>;
+template class FftSnapshot<float>;
+
+template <typename T, typename P>
+FftConstantQ<T, P>::FftConstantQ(uint32_t channels, double rate, double minFreq, double maxFreq, uint32_t binsPerOctave)
+: m_minFreq{minFreq}
+, m_binsPerOctave{binsPerOctave}
+, m_pending{channels, ChunkedStorage::Ring}
+{
+    maxFreq = std::min(maxFreq, rate / 2.0);
+    if (minFreq <= 0.0 || maxFreq <= minFreq || binsPerOctave == 0u) {
+        throw std::runtime_error("constant q range not usable!");
+    }
+    // the ratio of frequency to bandwidth is the same for all bins
+    const double q = 1.0 / (std::pow(2.0, 1.0 / static_cast<double>(binsPerOctave)) - 1.0);
+    const auto bins = static_cast<size_t>(std::floor(static_cast<double>(binsPerOctave) * std::log2(maxFreq / minFreq))) + 1u;
+    m_values.resize(bins);
+    // the lowest bin needs the longest kernel
+    m_fftSize = std::bit_ceil(static_cast<uint32_t>(std::ceil(q * rate / minFreq)));
+    m_pending.add(std::vector<T>(static_cast<size_t>(m_fftSize) * channels, T{}), nullptr);     // start with silence and keep the size
+    m_input = FftwApi<P>::alloc_real(m_fftSize);
+    m_result = FftwApi<P>::alloc_complex(m_fftSize / 2u + 1u);
+    m_plan = FftPlanner::planR2c<P>(static_cast<int>(m_fftSize), m_input, m_result);
+    if (!m_plan) {
+        FftwApi<P>::free(m_input);
+        FftwApi<P>::free(m_result);
+        throw std::runtime_error("constant q no plan for size " + std::to_string(m_fftSize));
+    }
+    createKernel(rate, q);
+}
+
+template <typename T, typename P>
+FftConstantQ<T, P>::~FftConstantQ()
+{
+    FftPlanner::destroy<P>(m_plan);
+    FftwApi<P>::free(m_input);
+    FftwApi<P>::free(m_result);
+}
+
+template <typename T, typename P>
+void
+FftConstantQ<T, P>::createKernel(double rate, double q)
+{
+    // the kernel of a bin is the spectrum of the windowed complex exponential,
+    //   computed as the real and imaginary part with the real transform
+    const size_t fftBins = m_fftSize / 2u + 1u;
+    auto re = FftwApi<P>::alloc_real(m_fftSize);
+    auto im = FftwApi<P>::alloc_real(m_fftSize);
+    auto reResult = FftwApi<P>::alloc_complex(fftBins);
+    auto imResult = FftwApi<P>::alloc_complex(fftBins);
+    std::vector<double> kernel(2u * fftBins);
+    m_offsets.push_back(0u);
+    for (size_t k = 0; k < m_values.size(); ++k) {
+        const double freq = getFrequency(k);
+        const auto length = std::min(static_cast<size_t>(std::ceil(q * rate / freq)), static_cast<size_t>(m_fftSize));
+        const size_t offset = (m_fftSize - length) / 2u;     // centered
+        // scaled so a sine gives its amplitude
+        const double norm = 2.0 / (HammingPolicy::AMPLITUDE_CORRECTION * static_cast<double>(length));
+        std::fill(re, re + m_fftSize, P{});
+        std::fill(im, im + m_fftSize, P{});
+        for (size_t n = 0; n < length; ++n) {
+            const double value = HammingPolicy::value(n, length) * norm;
+            const double phase = 2.0 * M_PI * q * static_cast<double>(n) / static_cast<double>(length);
+            re[offset + n] = static_cast<P>(value * std::cos(phase));
+            im[offset + n] = static_cast<P>(value * std::sin(phase));
+        }
+        FftwApi<P>::execute_dft_r2c(m_plan, re, reResult);
+        FftwApi<P>::execute_dft_r2c(m_plan, im, imResult);
+        double max{};
+        for (size_t j = 0; j < fftBins; ++j) {
+            // fft(re + i im) = fft(re) + i fft(im)
+            kernel[2u * j] = static_cast<double>(reResult[j][0]) - static_cast<double>(imResult[j][1]);
+            kernel[2u * j + 1u] = static_cast<double>(reResult[j][1]) + static_cast<double>(imResult[j][0]);
+            max = std::max(max, std::hypot(kernel[2u * j], kernel[2u * j + 1u]));
+        }
+        // keep the range above the threshold, the few smaller values in between don't matter
+        size_t first{fftBins};
+        size_t last{};
+        for (size_t j = 0; j < fftBins; ++j) {
+            if (std::hypot(kernel[2u * j], kernel[2u * j + 1u]) >= KERNEL_THRESHOLD * max) {
+                first = std::min(first, j);
+                last = j + 1u;
+            }
+        }
+        for (size_t j = first; j < last; ++j) {
+            m_kernel.push_back(static_cast<P>(kernel[2u * j] / static_cast<double>(m_fftSize)));
+            m_kernel.push_back(static_cast<P>(-kernel[2u * j + 1u] / static_cast<double>(m_fftSize)));
+        }
+        m_first.push_back(static_cast<uint32_t>(std::min(first, last)));
+        m_offsets.push_back(static_cast<uint32_t>(m_kernel.size() / 2u));
+    }
+    FftwApi<P>::free(re);
+    FftwApi<P>::free(im);
+    FftwApi<P>::free(reResult);
+    FftwApi<P>::free(imResult);
+#   ifdef DEBUG
+    std::cout << "FftConstantQ::createKernel"
+              << " bins " << m_values.size()
+              << " fft size " << m_fftSize
+              << " kernel size " << getKernelSize() << std::endl;
+#   endif
+}
+
+template <typename T, typename P>
+bool
+FftConstantQ<T, P>::push(const ChunkedArray<T>& data, uint32_t channel)
+{
+    const auto channels = m_pending.getChannels();
+    if (data.getChannels() != channels) {
+        throw std::runtime_error("constant q channels changed!");
+    }
+    if (channel != FftEngine<P>::CHANNEL_MID && channel >= channels) {
+        throw std::runtime_error("constant q channel not available!");
+    }
+    if (data.getFrames() == 0u) {
+        return false;
+    }
+    data.for_each_segment(0, data.size(), [this] (std::span<const T> segment) {
+        m_pending.add(segment, nullptr);
+    });
+    const auto frames = m_pending.getFrames();
+    m_pending.drop((frames - m_fftSize) * channels);    // keep the most recent
+    auto start = std::chrono::steady_clock::now();
+    if (channel == FftEngine<P>::CHANNEL_MID) {
+        m_pending.downmix_mid_side(0, m_fftSize, m_input, static_cast<P*>(nullptr), P{1});
+    }
+    else {
+        m_pending.copy_channel(0, m_fftSize, channel, m_input, P{1});
+    }
+    FftwApi<P>::execute(m_plan);
+    // as the kernels are short in the spectrum this is just a few products for each bin
+    const auto scale = static_cast<P>(m_scale * ChunkedArray<T>::INPUT_SCALE);
+    const P* result = &m_result[0][0];
+    for (size_t k = 0; k < m_values.size(); ++k) {
+        const P* kernel = m_kernel.data() + 2u * m_offsets[k];
+        const P* values = result + 2u * m_first[k];
+        const size_t length = m_offsets[k + 1u] - m_offsets[k];
+        P sumRe{};
+        P sumIm{};
+        for (size_t j = 0; j < length; ++j) {
+            const P xr = values[2u * j];
+            const P xi = values[2u * j + 1u];
+            const P kr = kernel[2u * j];
+            const P ki = kernel[2u * j + 1u];
+            sumRe += xr * kr - xi * ki;
+            sumIm += xr * ki + xi * kr;
+        }
+        m_values[k] = std::sqrt(sumRe * sumRe + sumIm * sumIm) * scale;
+    }
+    auto end = std::chrono::steady_clock::now();
+    m_frameTime = std::chrono::duration_cast<std::chrono::duration<double, std::micro>>(end - start).count();
+    return true;
+}
+
+template <typename T, typename P>
+const std::vector<P>&
+FftConstantQ<T, P>::getValues()
+{
+    return m_values;
+}
+
+template <typename T, typename P>
+void
+FftConstantQ<T, P>::adjust(std::vector<float>& fout, size_t cnt, double factor)
+{
+    fout.resize(cnt);
+    const size_t bins = m_values.size();
+    for (size_t n = 0; n < cnt; ++n) {
+        // with more tiles than bins these repeat
+        size_t begin = bins * n / cnt;
+        size_t end = std::max(bins * (n + 1u) / cnt, begin + 1u);
+        auto max = *std::max_element(m_values.begin() + begin, m_values.begin() + end);
+        fout[n] = static_cast<float>(static_cast<double>(max) * factor);
+    }
+}
+
+template <typename T, typename P>
+double
+FftConstantQ<T, P>::getFrequency(size_t bin)
+{
+    return m_minFreq * std::pow(2.0, static_cast<double>(bin) / static_cast<double>(m_binsPerOctave));
+}
+
+template <typename T, typename P>
+size_t
+FftConstantQ<T, P>::getBinCount()
+{
+    return m_values.size();
+}
+
+template <typename T, typename P>
+uint32_t
+FftConstantQ<T, P>::getFftSize()
+{
+    return m_fftSize;
+}
+
+template <typename T, typename P>
+size_t
+FftConstantQ<T, P>::getKernelSize()
+{
+    return m_kernel.size() / 2u;
+}
+
+template <typename T, typename P>
+double
+FftConstantQ<T, P>::getFrameTime()
+{
+    return m_frameTime;
+}
+
+template <typename T, typename P>
+double
+FftConstantQ<T, P>::getScale()
+{
+    return m_scale;
+}
+
+template <typename T, typename P>
+void
+FftConstantQ<T, P>::setScale(double scale)
+{
+    m_scale = scale;
+}
+
+template <typename T, typename P>
+void
+FftConstantQ<T, P>::reset()
+{
+    // back to silence
+    const auto channels = m_pending.getChannels();
+    m_pending.drop(m_pending.size());
+    m_pending.add(std::vector<T>(static_cast<size_t>(m_fftSize) * channels, T{}), nullptr);
+    std::ranges::fill(m_values, P{});
+}
+
+// need template instantiation
+template class FftConstantQ<int16_t, double>;
+template class FftConstantQ<int16_t, float>;
+template class FftConstantQ<float, double>;
+template class FftConstantQ<float, float>;
+
+template <uint32_t windowSize, typename P>
+Fft<windowSize, P>::Fft(const std::shared_ptr<WindowFunction<windowSize>>& windowFunction)
+: FftEngine<P>{windowSize, createWindow(windowFunction), windowFunction->getCorrection(), windowFunction->getEnergyCorrection()}
+{
+}
+
+template <uint32_t windowSize, typename P>
+std::shared_ptr<const std::vector<P>>
+Fft<windowSize, P>::createWindow(const std::shared_ptr<WindowFunction<windowSize>>& windowFunction)
+{
+    auto window = std::make_shared<std::vector<P>>(windowSize);
+    for (size_t i = 0; i < windowSize; ++i) {
+        (*window)[i] = static_cast<P>(windowFunction->windowing(i));
+    }
+    return window;
+}
+
+template <uint32_t windowSize, typename P>
+std::shared_ptr<Spectrum<windowSize, P>>
+Fft<windowSize, P>::execute(const ChunkedArray<int16_t>& in, uint32_t channel)
+{
+    auto spectrum = std::make_shared<Spectrum<windowSize, P>>();
+    this->executeSamples(in, channel, *spectrum);
+    return spectrum;
+}
+
+template <uint32_t windowSize, typename P>
+std::shared_ptr<Spectrum<windowSize, P>>
+Fft<windowSize, P>::execute(const ChunkedArray<float>& in, uint32_t channel)
+{
+    auto spectrum = std::make_shared<Spectrum<windowSize, P>>();
+    this->executeSamples(in, channel, *spectrum);
+    return spectrum;
+}
+
+// need template instantiation
+template class Fft<2048u>;
+
+// maybe audacious is right, avoid the lowest frequencies,
+// as for modern music these are most prominent
+template class Fft<512u>;
+
+// only 4 testing
+template class Fft<256u>;
+
+template class Fft<2048u, float>;
+
+template class Fft<512u, float>;
@@ -23,6 +23,16 @@
 #include <memory>
 #include <cstdint>
 #include <array>
+#include <mutex>
+#include <string>
+#include <filesystem>
+#include <map>
+#include <utility>
+#include <tuple>
+#include <span>
+#include <functional>
+#include <thread>
+#include <cmath>
 //#include <complex.h>  seems not to work
 #include <fftw3.h>
 #include <vector>
@@ -35,6 +45,7 @@ class WindowFunction
 {
 public:
     virtual double windowing(size_t idx) = 0;
+    // the amplitude (coherent gain) correction, the level of a sine is scaled by this
     virtual double getCorrection()
     {
         double sum{};
@@ -43,10 +54,141 @@ public:
         }
         return sum / static_cast<double>(windowSize);
     }
+    // the energy (rms) correction, the level of noise is scaled by this
+    virtual double getEnergyCorrection()
+    {
+        double sum{};
+        for (size_t i = 0; i < windowSize; ++i) {
+            sum += windowing(i) * windowing(i);
+        }
+        return std::sqrt(sum / static_cast<double>(windowSize));
+    }
 };
 
-template <uint32_t windowSize = 2048u>
-class HammingWindow
+// the windows as policies, value(idx, size) gives the symmetric window
+//   see https://en.wikipedia.org/wiki/Window_function,
+//   the corrections are the values for large sizes
+
+// a0 - a1 cos(x) + a2 cos(2x) - ...
+template <size_t terms>
+constexpr double
+cosineSum(const std::array<double, terms>& a, size_t idx, size_t size)
+{
+    auto end = 2.0 * M_PI / static_cast<double>(size - 1);
+    double value = a[0];
+    for (size_t k = 1; k < terms; ++k) {
+        auto term = a[k] * std::cos(static_cast<double>(k) * (static_cast<double>(idx) * end));
+        value = (k % 2 == 1) ? value - term : value + term;
+    }
+    return value;
+}
+
+template <size_t terms>
+constexpr double
+cosineSumEnergy(const std::array<double, terms>& a)
+{
+    double sum = a[0] * a[0];
+    for (size_t k = 1; k < terms; ++k) {
+        sum += a[k] * a[k] / 2.0;
+    }
+    return std::sqrt(sum);
+}
+
+struct HannPolicy
+{
+    static constexpr std::array<double, 2> COEFFICIENTS{0.5, 0.5};
+    static constexpr double value(size_t idx, size_t size)
+    {
+        return cosineSum(COEFFICIENTS, idx, size);
+    }
+    static constexpr double AMPLITUDE_CORRECTION{COEFFICIENTS[0]};
+    static constexpr double ENERGY_CORRECTION{cosineSumEnergy(COEFFICIENTS)};
+};
+
+struct HammingPolicy
+{
+    static constexpr std::array<double, 2> COEFFICIENTS{0.53836, 0.46164};   // modified factors
+    static constexpr double value(size_t idx, size_t size)
+    {
+        return cosineSum(COEFFICIENTS, idx, size);
+    }
+    static constexpr double AMPLITUDE_CORRECTION{COEFFICIENTS[0]};
+    static constexpr double ENERGY_CORRECTION{cosineSumEnergy(COEFFICIENTS)};
+};
+
+struct BlackmanHarrisPolicy
+{
+    static constexpr std::array<double, 4> COEFFICIENTS{0.35875, 0.48829, 0.14128, 0.01168};
+    static constexpr double value(size_t idx, size_t size)
+    {
+        return cosineSum(COEFFICIENTS, idx, size);
+    }
+    static constexpr double AMPLITUDE_CORRECTION{COEFFICIENTS[0]};
+    static constexpr double ENERGY_CORRECTION{cosineSumEnergy(COEFFICIENTS)};
+};
+
+// the amplitude is accurate regardless where the frequency falls between bins
+struct FlatTopPolicy
+{
+    static constexpr std::array<double, 5> COEFFICIENTS{0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368};
+    static constexpr double value(size_t idx, size_t size)
+    {
+        return cosineSum(COEFFICIENTS, idx, size);
+    }
+    static constexpr double AMPLITUDE_CORRECTION{COEFFICIENTS[0]};
+    static constexpr double ENERGY_CORRECTION{cosineSumEnergy(COEFFICIENTS)};
+};
+
+// modified bessel function of the first kind, as power series
+constexpr double
+besselI0(double x)
+{
+    const double quarter = x * x / 4.0;
+    double term{1.0};
+    double sum{1.0};
+    for (int k = 1; k < 500 && term > sum * 1.0e-17; ++k) {
+        term *= quarter / (static_cast<double>(k) * static_cast<double>(k));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double
+kaiser(double beta, double x)       // x -1...1
+{
+    return besselI0(beta * std::sqrt(1.0 - x * x)) / besselI0(beta);
+}
+
+// rms of the kaiser window by simpson integration
+constexpr double
+kaiserEnergy(double beta)
+{
+    constexpr int steps{256};
+    double sum{};
+    for (int s = 0; s <= steps; ++s) {
+        auto value = kaiser(beta, static_cast<double>(s) / static_cast<double>(steps));
+        double weight = (s == 0 || s == steps) ? 1.0 : (s % 2 == 1 ? 4.0 : 2.0);
+        sum += weight * value * value;
+    }
+    return std::sqrt(sum / (3.0 * static_cast<double>(steps)));
+}
+
+// @param beta tradeoff between main lobe width and side lobe level, 8.6 is similar to blackman harris
+template <double beta = 8.6>
+struct KaiserPolicy
+{
+    static constexpr double value(size_t idx, size_t size)
+    {
+        return kaiser(beta, 2.0 * static_cast<double>(idx) / static_cast<double>(size - 1) - 1.0);
+    }
+    static constexpr double BETA{beta};
+    static constexpr double AMPLITUDE_CORRECTION{std::sinh(beta) / (beta * besselI0(beta))};
+    static constexpr double ENERGY_CORRECTION{kaiserEnergy(beta)};
+};
+
+// the window for a fixed size from a policy, the table is built at compile time
+template <typename Policy, uint32_t windowSize = 2048u>
+class PolicyWindow
 : public WindowFunction<windowSize>
 {
 public:
@@ -56,26 +198,40 @@ public:
     }
     double getCorrection() override
     {
-        return HAMMING_OFFS;
+        return Policy::AMPLITUDE_CORRECTION;
+    }
+    double getEnergyCorrection() override
+    {
+        return Policy::ENERGY_CORRECTION;
+    }
+    static constexpr const std::array<double, windowSize>& getValues()
+    {
+        return window;
     }
-    static constexpr auto HAMMING_OFFS{0.53836};
-    static constexpr auto HAMMING_FACTOR{0.46164};
 
 protected:
-    static consteval // Create a hamming window see https://en.wikipedia.org/wiki/Window_function (modified factors from there)
-    std::array<double, windowSize> hamming()
+    static consteval
+    std::array<double, windowSize> create()
     {
         std::array<double, windowSize> buffer;
-        auto end = 2.0 * M_PI / static_cast<double>(windowSize - 1);
-        for(size_t i = 0; i < windowSize; i++) {
-            buffer[i] =  HAMMING_OFFS - (HAMMING_FACTOR * std::cos( (static_cast<double>(i) * end)));
+        for (size_t i = 0; i < windowSize; ++i) {
+            buffer[i] = Policy::value(i, windowSize);
         }
         return buffer;
     }
-    static constexpr std::array<double, windowSize> window = hamming();
+    static constexpr std::array<double, windowSize> window = create();
 
 };
 
+template <uint32_t windowSize = 2048u>
+class HammingWindow
+: public PolicyWindow<HammingPolicy, windowSize>
+{
+public:
+    static constexpr auto HAMMING_OFFS{HammingPolicy::COEFFICIENTS[0]};
+    static constexpr auto HAMMING_FACTOR{HammingPolicy::COEFFICIENTS[1]};
+};
+
 // need template instantiation
 template class HammingWindow<2048u>;
 
@@ -94,26 +250,218 @@ public:
 };
 
 
-template <uint32_t windowSize = 2048u>
-class Spectrum
+// map the precision to the fftw api, fftw for double and fftwf for float
+template <typename P>
+struct FftwApi;
+
+template <>
+struct FftwApi<double>
+{
+    using complex = fftw_complex;
+    using plan = fftw_plan;
+    static constexpr auto WISDOM_FILE{"fftw-wisdom"};
+
+    static double* alloc_real(size_t n)
+    {
+        return fftw_alloc_real(n);
+    }
+    static complex* alloc_complex(size_t n)
+    {
+        return fftw_alloc_complex(n);
+    }
+    static void free(void* p)
+    {
+        fftw_free(p);
+    }
+    static plan plan_dft_r2c_1d(int n, double* in, complex* out, unsigned flags)
+    {
+        return fftw_plan_dft_r2c_1d(n, in, out, flags);
+    }
+    static plan plan_many_dft_r2c(int n, int howmany, double* in, int idist, complex* out, int odist, unsigned flags)
+    {
+        return fftw_plan_many_dft_r2c(1, &n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, flags);
+    }
+    static void execute(const plan p)
+    {
+        fftw_execute(p);
+    }
+    static void execute_dft_r2c(const plan p, double* in, complex* out)
+    {
+        fftw_execute_dft_r2c(p, in, out);
+    }
+    static void destroy_plan(plan p)
+    {
+        fftw_destroy_plan(p);
+    }
+    static int init_threads()
+    {
+        return fftw_init_threads();
+    }
+    static void plan_with_nthreads(int nthreads)
+    {
+        fftw_plan_with_nthreads(nthreads);
+    }
+    static int import_wisdom_from_filename(const char* filename)
+    {
+        return fftw_import_wisdom_from_filename(filename);
+    }
+    static int export_wisdom_to_filename(const char* filename)
+    {
+        return fftw_export_wisdom_to_filename(filename);
+    }
+};
+
+template <>
+struct FftwApi<float>
+{
+    using complex = fftwf_complex;
+    using plan = fftwf_plan;
+    static constexpr auto WISDOM_FILE{"fftwf-wisdom"};
+
+    static float* alloc_real(size_t n)
+    {
+        return fftwf_alloc_real(n);
+    }
+    static complex* alloc_complex(size_t n)
+    {
+        return fftwf_alloc_complex(n);
+    }
+    static void free(void* p)
+    {
+        fftwf_free(p);
+    }
+    static plan plan_dft_r2c_1d(int n, float* in, complex* out, unsigned flags)
+    {
+        return fftwf_plan_dft_r2c_1d(n, in, out, flags);
+    }
+    static plan plan_many_dft_r2c(int n, int howmany, float* in, int idist, complex* out, int odist, unsigned flags)
+    {
+        return fftwf_plan_many_dft_r2c(1, &n, howmany, in, nullptr, 1, idist, out, nullptr, 1, odist, flags);
+    }
+    static void execute(const plan p)
+    {
+        fftwf_execute(p);
+    }
+    static void execute_dft_r2c(const plan p, float* in, complex* out)
+    {
+        fftwf_execute_dft_r2c(p, in, out);
+    }
+    static void destroy_plan(plan p)
+    {
+        fftwf_destroy_plan(p);
+    }
+    static int init_threads()
+    {
+        return fftwf_init_threads();
+    }
+    static void plan_with_nthreads(int nthreads)
+    {
+        fftwf_plan_with_nthreads(nthreads);
+    }
+    static int import_wisdom_from_filename(const char* filename)
+    {
+        return fftwf_import_wisdom_from_filename(filename);
+    }
+    static int export_wisdom_to_filename(const char* filename)
+    {
+        return fftwf_export_wisdom_to_filename(filename);
+    }
+};
+
+enum class SpectrumScale
+{
+    Linear,
+    Logarithmic,
+    Mel,
+    Bark
+};
+
+// a perceptual filterbank for the Mel or Bark scale,
+//   the triangular filters are equally spaced on the scale,
+//   each covers only a few adjacent bins so just these weights are kept
+template <typename P>
+class SpectrumFilterbank
 {
 public:
-    Spectrum();
-    explicit Spectrum(const Spectrum& orig) = delete;
-    virtual ~Spectrum() = default;
+    // @param bins of the spectrum, cnt filters from 0 up to usageFactor * rate / 2
+    SpectrumFilterbank(size_t bins, size_t cnt, double rate, double usageFactor, SpectrumScale scale);
+    explicit SpectrumFilterbank(const SpectrumFilterbank& orig) = delete;
+    virtual ~SpectrumFilterbank() = default;
+    // fout[n] = the weighted sum of the bins of filter n * factor,
+    //   normalized by the filter weights unless keepSum
+    void apply(const std::vector<P>& sum, std::vector<float>& fout, double factor, bool keepSum) const;
+    size_t getCount() const;
+    // the weights of filter n start at this bin
+    uint32_t getFirst(size_t n) const;
+    std::span<const P> getWeights(size_t n) const;
+
+private:
+    std::vector<uint32_t> m_first;
+    std::vector<uint32_t> m_offsets;    // filter n has the weights [m_offsets[n], m_offsets[n + 1])
+    std::vector<P> m_weights;
+    std::vector<P> m_norm;              // 1 / sum of the weights of each filter
+};
+
+// the mapping of the spectrum bins to the display tiles for adjustLin/adjustLog,
+//   as the tiles are ascending with the bins, tile n uses the bins [bounds[n], bounds[n + 1]).
+//   These depend only on the settings so they are built once and shared,
+//   as are the filterbanks for adjustFilterbank
+class SpectrumMapping
+{
+public:
+    // for the Linear or Logarithmic scale
+    static std::shared_ptr<const std::vector<uint32_t>> get(size_t bins, size_t cnt, double usageFactor, SpectrumScale scale);
+    // for the Mel or Bark scale
+    template <typename P>
+    static std::shared_ptr<const SpectrumFilterbank<P>> getFilterbank(size_t bins, size_t cnt, double rate, double usageFactor, SpectrumScale scale);
+    // call if the settings changed, to drop the unused
+    static void clear();
+    // hz to the Mel (O'Shaughnessy) or Bark (Traunmueller) scale and back
+    static double toScale(double hz, SpectrumScale scale);
+    static double fromScale(double value, SpectrumScale scale);
+    static constexpr size_t MAX_MAPPINGS{16u};
+protected:
+    static std::vector<uint32_t> create(size_t bins, size_t cnt, double usageFactor, SpectrumScale scale);
+    // requires the lock to be held
+    template <typename P>
+    static std::map<std::tuple<size_t, size_t, double, double, SpectrumScale>, std::shared_ptr<const SpectrumFilterbank<P>>>& getFilterbanks();
+private:
+    using Key = std::tuple<size_t, size_t, double, SpectrumScale>;
+    static std::mutex m_mutex;
+    static std::map<Key, std::shared_ptr<const std::vector<uint32_t>>> m_mappings;
+};
+
+// @param P precision used for the values, double or float (fftwf)
+template <typename P = double>
+class SpectrumBase
+{
+public:
+    SpectrumBase(uint32_t windowSize);
+    explicit SpectrumBase(const SpectrumBase& orig) = delete;
+    virtual ~SpectrumBase() = default;
 
     // linear adjustment for frequency
     std::vector<float> adjustLin(size_t cnt, double usageFactor, double factor = 1.0, bool keepSum = false);
+    // as above into fout, to reuse it for each frame
+    void adjustLin(std::vector<float>& fout, size_t cnt, double usageFactor, double factor = 1.0, bool keepSum = false);
     // logarithmic adjustment for frequency
     //   the db adjustment for level would be nice,
     //   but we have to deal with changing levels (as we are on the end of the processing chain)
     //     and the lib-fft functions i could not make a fixed connections from input-levels to output
     std::vector<float> adjustLog(size_t cnt, double usageFactor, double factor = 1.0, bool keepSum = false);
-    void add(fftw_complex* fft_result);
+    void adjustLog(std::vector<float>& fout, size_t cnt, double usageFactor, double factor = 1.0, bool keepSum = false);
+    // perceptual adjustment with a Mel or Bark filterbank
+    // @param rate the sample rate
+    void adjustFilterbank(std::vector<float>& fout, size_t cnt, double usageFactor, double rate, SpectrumScale scale, double factor = 1.0, bool keepSum = false);
+    void add(typename FftwApi<P>::complex* fft_result);
     void scale(double nScale);
     double getMax();
     void setAddScale(double addScale);
-    std::vector<double>& getSum()
+    // clear the values to reuse this
+    void reset();
+    // sum up the values of other (same size)
+    void add(const SpectrumBase& other);
+    std::vector<P>& getSum()
     {
         return m_sum;
     }
@@ -122,16 +470,43 @@ public:
         m_sum[pos] += val;
     }
     std::vector<double> getVector()
+    {
+        return std::vector<double>(m_sum.begin(), m_sum.end());
+    }
+    // the values without a copy, valid as long as this is not changed
+    std::span<const P> getValues() const
     {
         return m_sum;
     }
+    uint32_t getWindowSize()
+    {
+        return m_windowSize;
+    }
+protected:
+    // one pass over the tile bounds, summing (or the maximum of) the bins of each tile
+    void gather(std::vector<float>& fout, const std::vector<uint32_t>& bounds, double factor, bool keepSum, bool useMax);
+
 private:
-    std::vector<double> m_sum;
+    uint32_t m_windowSize;
+    std::vector<P> m_sum;
     double m_addScale{1.0};
-    static std::vector<size_t> m_lookup;
 
 };
 
+// the spectrum as delivered by the fixed size Fft<windowSize>
+template <uint32_t windowSize = 2048u, typename P = double>
+class Spectrum
+: public SpectrumBase<P>
+{
+public:
+    Spectrum()
+    : SpectrumBase<P>{windowSize}
+    {
+    }
+    explicit Spectrum(const Spectrum& orig) = delete;
+    virtual ~Spectrum() = default;
+};
+
 class SignalGenerator
 {
 public:
@@ -167,35 +542,424 @@ public:
 };
 
 
-template <uint32_t windowSize = 2048u>
-class Fft
+// effort spent by fftw to find a fast plan,
+//   anything beyond Estimate is only feasible with the wisdom kept
+enum class FftPlanning
+{
+    Estimate,
+    Measure,
+    Patient
+};
+
+// the windows available by type, to be shared by the engines
+enum class FftWindowType
+{
+    Hamming,
+    Hann,
+    BlackmanHarris,
+    FlatTop,
+    Kaiser
+};
+
+// access to the window policies by type
+class FftWindows
 {
 public:
-    Fft(const std::shared_ptr<WindowFunction<windowSize>>& windowFunction);
-    explicit Fft(const Fft& orig) = delete;
-    virtual ~Fft();
-    std::shared_ptr<Spectrum<windowSize>> execute(const ChunkedArray<int16_t>& data);
+    template <typename P>
+    static std::vector<P> create(FftWindowType window, uint32_t windowSize);
+    static double getAmplitudeCorrection(FftWindowType window);
+    static double getEnergyCorrection(FftWindowType window);
+    static std::string toId(FftWindowType window);
+    static FftWindowType fromId(const std::string& id);
+
+    static constexpr auto WINDOW_HAMMING{"hamming"};
+    static constexpr auto WINDOW_HANN{"hann"};
+    static constexpr auto WINDOW_BLACKMAN_HARRIS{"blackmanHarris"};
+    static constexpr auto WINDOW_FLAT_TOP{"flatTop"};
+    static constexpr auto WINDOW_KAISER{"kaiser"};
+protected:
+    // call f with the policy for window
+    template <typename F>
+    static auto visit(FftWindowType window, F&& f)
+    {
+        switch (window) {
+        case FftWindowType::Hann:
+            return f(HannPolicy{});
+        case FftWindowType::BlackmanHarris:
+            return f(BlackmanHarrisPolicy{});
+        case FftWindowType::FlatTop:
+            return f(FlatTopPolicy{});
+        case FftWindowType::Kaiser:
+            return f(KaiserPolicy<>{});
+        case FftWindowType::Hamming:
+        default:
+            return f(HammingPolicy{});
+        }
+    }
+};
+
+// the plans for one size, shared by all engines of this size,
+//   these are executed on the buffers of each engine (fftw_execute_dft_r2c),
+//   which works as these are allocated and strided with the same alignment
+template <typename P>
+class FftSetup
+{
+public:
+    FftSetup(uint32_t windowSize);
+    explicit FftSetup(const FftSetup& orig) = delete;
+    virtual ~FftSetup();
+
+    uint32_t getWindowSize() const;
+    // transforms a single window
+    typename FftwApi<P>::plan getPlan() const;
+    // transforms BATCH_WINDOWS windows getInputStride() apart, results getResultStride() apart
+    typename FftwApi<P>::plan getBatchPlan() const;
+    static uint32_t getBins(uint32_t windowSize)
+    {
+        return windowSize / 2u + 1u;
+    }
+    // keep each batch input row aligned (16 bytes for float, e.g. window 6 would break it)
+    static uint32_t getInputStride(uint32_t windowSize)
+    {
+        return (windowSize + 3u) & ~3u;
+    }
+    // keep each batch result row aligned
+    static uint32_t getResultStride(uint32_t windowSize)
+    {
+        return (getBins(windowSize) + 3u) & ~3u;
+    }
+    // limits the batch memory to ~1MB for 2k windows, longer inputs use multiple batches
+    static constexpr uint32_t BATCH_WINDOWS{32u};
+
+private:
+    uint32_t m_windowSize;
+    typename FftwApi<P>::plan m_plan{};
+    typename FftwApi<P>::plan m_batchPlan{};
+};
+
+// the buffers for a batch of windows as used with the FftSetup plans,
+//   each thread transforming needs its own
+template <typename P>
+class FftBuffers
+{
+public:
+    FftBuffers(uint32_t windowSize);
+    explicit FftBuffers(const FftBuffers& orig) = delete;
+    virtual ~FftBuffers();
+
+    P* getInput(uint32_t slot = 0u);
+    typename FftwApi<P>::complex* getResult(uint32_t slot = 0u);
+
+private:
+    uint32_t m_inputStride;
+    uint32_t m_resultStride;
+    P* m_input{};                                   // BATCH_WINDOWS * inputStride
+    typename FftwApi<P>::complex* m_result{};       // BATCH_WINDOWS * resultStride
+};
+
+// the fftw planner is not thread safe and the gained wisdom is global,
+//   so all planning goes through here.
+// The wisdom is kept in $XDG_CACHE_HOME/glscene/fftw-wisdom,
+//   so the expensive planning is done once per machine (and size)
+class FftPlanner
+{
+public:
+    static FftPlanning getPlanning();
+    static void setPlanning(FftPlanning planning);
+    static std::string toId(FftPlanning planning);
+    static FftPlanning fromId(const std::string& id);
+    // the wisdom is kept by precision
+    template <typename P = double>
+    static std::filesystem::path getWisdomFile();
+    template <typename P>
+    static typename FftwApi<P>::plan planR2c(int n, P* in, typename FftwApi<P>::complex* out);
+    // plan howmany transforms of size n, input rows are n apart, output rows odist
+    template <typename P>
+    static typename FftwApi<P>::plan planManyR2c(int n, int howmany, P* in, int idist, typename FftwApi<P>::complex* out, int odist);
+    // plan a (large) transform to be run on threads, the other plans stay single threaded
+    //   (without the fftw threads library this is a single threaded plan)
+    template <typename P>
+    static typename FftwApi<P>::plan planThreadedR2c(int n, int threads, P* in, typename FftwApi<P>::complex* out);
+    template <typename P>
+    static void destroy(typename FftwApi<P>::plan plan);
+    // the plans are cached by size (the hop doesn't matter for planning),
+    //   so switching the resolution costs nothing after the first use
+    template <typename P>
+    static std::shared_ptr<const FftSetup<P>> getSetup(uint32_t windowSize);
+    // the window tables are cached by type and size
+    template <typename P>
+    static std::shared_ptr<const std::vector<P>> getWindow(FftWindowType window, uint32_t windowSize);
+
+    static constexpr auto PLANNING_ESTIMATE{"E"};
+    static constexpr auto PLANNING_MEASURE{"M"};
+    static constexpr auto PLANNING_PATIENT{"P"};
+protected:
+    static unsigned getFlags();
+    // these require the lock to be held
+    template <typename P>
+    static void loadWisdom();
+    template <typename P>
+    static void saveWisdom();
+    // @return false if the fftw threads are not available
+    template <typename P>
+    static bool initThreads();
+    // plan with the wisdom if possible, otherwise with the requested effort
+    template <typename P, typename F>
+    static typename FftwApi<P>::plan plan(int n, F&& planner);
+    template <typename P>
+    struct Cache
+    {
+        std::map<uint32_t, std::shared_ptr<const FftSetup<P>>> setups;
+        std::map<std::pair<FftWindowType, uint32_t>, std::shared_ptr<const std::vector<P>>> windows;
+    };
+    // requires the cache lock to be held
+    template <typename P>
+    static Cache<P>& getCache();
+    // the plans were made with the previous effort
+    static void clearSetups();
+
+private:
+    static std::mutex m_mutex;
+    static std::mutex m_cacheMutex;     // if both are needed, take this first
+    static FftPlanning m_planning;
+};
+
+// runtime sized short time fourier transform,
+//   the plans and the window come from the FftPlanner cache, so a engine is cheap to create
+// @param P precision of the transform, double or float (fftwf),
+//   float doubles the simd width and halves the buffers, for display this is precise enough
+template <typename P = double>
+class FftEngine
+{
+public:
+    // @param hopSize distance of the windows, 0 for windowSize (no overlap)
+    FftEngine(uint32_t windowSize, uint32_t hopSize = 0u, FftWindowType window = FftWindowType::Hamming);
+    explicit FftEngine(const FftEngine& orig) = delete;
+    virtual ~FftEngine();
+    // @param channel select the channel to analyze, or CHANNEL_MID for the stereo mid signal
+    std::shared_ptr<SpectrumBase<P>> execute(const ChunkedArray<int16_t>& data, uint32_t channel = 0u);
+    std::shared_ptr<SpectrumBase<P>> execute(const ChunkedArray<float>& data, uint32_t channel = 0u);
+    // analyze into out (reset before), to reuse it for each call
+    //   out has to be of the same windowSize
+    void execute(const ChunkedArray<int16_t>& data, SpectrumBase<P>& out, uint32_t channel = 0u);
+    void execute(const ChunkedArray<float>& data, SpectrumBase<P>& out, uint32_t channel = 0u);
     // since there are many factors test the value out
     double calibrate(double to = 1.0);
     double getScale();
     void setScale(double scale);
+    // the corrections of the used window
+    double getAmplitudeCorrection();
+    double getEnergyCorrection();
+    uint32_t getWindowSize();
+    uint32_t getBins();
     uint32_t getHopSize();
     void setHopSize(uint32_t hopSize);
+    // transform BATCH_WINDOWS hops with one call (default), otherwise one window at a time
+    bool isBatched();
+    void setBatched(bool batched);
+    // threads to split the windows of long inputs, 1 (default) keeps the calling thread,
+    //   0 uses one for each core, the result is deterministic for a given thread count
+    uint32_t getThreads();
+    void setThreads(uint32_t threads);
+    // the windows each thread shall get at least, to make up for starting it
+    static constexpr size_t WINDOWS_PER_THREAD{256u};
     static constexpr size_t REAL{0};
     static constexpr size_t IMAG{1};
+    static constexpr uint32_t CHANNEL_MID{0xffffffffu};
+    static constexpr uint32_t BATCH_WINDOWS{FftSetup<P>::BATCH_WINDOWS};
 
 protected:
+    // for a window not available by type
+    FftEngine(uint32_t windowSize, const std::shared_ptr<const std::vector<P>>& window, double amplitudeCorrection, double energyCorrection);
+    // the levels are kept at what the hamming window gives (the display was tuned with it),
+    //   the other windows are corrected to give the same level for a sine
+    double getAddScale(double inputScale);
+    using Complex = typename FftwApi<P>::complex;
+    template<typename T>
+    void executeSamples(const ChunkedArray<T>& data, uint32_t channel, SpectrumBase<P>& spectrum);
+    // analyze the windows [first, last) into spectrum, as this uses the given buffers
+    //   it can be used by multiple threads
+    template<typename T>
+    void executeWindows(const ChunkedArray<T>& data, uint32_t channel, size_t first, size_t last, FftBuffers<P>& buffers, SpectrumBase<P>& spectrum);
+    template<typename T>
+    void executeParallel(const ChunkedArray<T>& data, uint32_t channel, size_t windows, uint32_t threads, SpectrumBase<P>& spectrum);
+    // copy the window at pos (frames) into the input slot and apply the window function
+    // @return the frames copied, the remaining are zero padded
+    template<typename T>
+    size_t fillWindow(const ChunkedArray<T>& data, size_t pos, uint32_t channel, FftBuffers<P>& buffers, uint32_t slot);
+    // transform the slots [0, windows)
+    void transform(FftBuffers<P>& buffers, uint32_t windows);
+    // the slots used by one transform
+    uint32_t getBatchWindows();
+    FftBuffers<P>& getBuffers();
 
 private:
-    uint32_t m_hopSize{windowSize};
-    fftw_complex* m_fft_input{};
-    fftw_complex* m_fft_result{};
-    fftw_plan m_plan_forward;
+    uint32_t m_windowSize;
+    uint32_t m_hopSize;
+    std::shared_ptr<const FftSetup<P>> m_setup;
+    std::shared_ptr<const std::vector<P>> m_window;     // the window function values in the used precision
+    FftBuffers<P> m_buffers;            // windowSize / 2 + 1 bins as the input is real
+    bool m_batched{true};
+    uint32_t m_threads{1u};
+    double m_scale{1.0};
+    double m_amplitudeCorrection;
+    double m_energyCorrection;
+};
+
+// streaming analysis of the captured batches (e.g. from PulseIn::read),
+//   the samples not used by a complete window are kept for the next push,
+//   so each hop is analyzed once, regardless how the capture is split up
+// @param T the sample type
+template <typename T, typename P = double>
+class FftStream
+: public FftEngine<P>
+{
+public:
+    using FrameListener = std::function<void(const SpectrumBase<P>& frame)>;
+
+    FftStream(uint32_t channels, uint32_t windowSize, uint32_t hopSize = 0u, FftWindowType window = FftWindowType::Hamming);
+    explicit FftStream(const FftStream& orig) = delete;
+    virtual ~FftStream() = default;
+    // analyze the windows completed with data, each is also passed to the frame listener
+    // @return the average of the completed windows, nullptr if data did not complete a window
+    std::shared_ptr<SpectrumBase<P>> push(const ChunkedArray<T>& data, uint32_t channel = 0u);
+    // as above into out, that is only changed if a window was completed
+    // @return true if out was updated
+    bool push(const ChunkedArray<T>& data, SpectrumBase<P>& out, uint32_t channel = 0u);
+    // called with the spectrum of each hop, the frame is valid only during the call
+    void setFrameListener(const FrameListener& frameListener);
+    // discard the kept samples e.g. if the source changed
+    void reset();
+    // frames kept for the next push
+    size_t getPending();
+    // windows analyzed since construction or reset
+    uint64_t getWindows();
+
+private:
+    ChunkedArray<T> m_pending;
+    size_t m_skip{};        // frames to skip for the next window, if hop > windowSize
+    std::shared_ptr<SpectrumBase<P>> m_frame;
+    FrameListener m_frameListener;
+    uint64_t m_windows{};
+};
+
+// a single long transform (e.g. 64k to 1M points) of the recent signal to inspect the fine tonal structure,
+//   as this takes a while it is done with the fftw threads
+template <typename P = double>
+class FftSnapshot
+{
+public:
+    // @param threads for the transform, 0 for one per core
+    FftSnapshot(uint32_t size, uint32_t threads = 0u, FftWindowType window = FftWindowType::Hamming);
+    explicit FftSnapshot(const FftSnapshot& orig) = delete;
+    virtual ~FftSnapshot();
+    // transform the last size frames of data, a shorter input is zero padded
+    // @param channel select the channel to analyze, or CHANNEL_MID for the stereo mid signal
+    // @return the magnitudes of the size / 2 + 1 bins, scaled like SpectrumBase
+    const std::vector<P>& execute(const ChunkedArray<int16_t>& data, uint32_t channel = 0u);
+    const std::vector<P>& execute(const ChunkedArray<float>& data, uint32_t channel = 0u);
+    const std::vector<P>& getMagnitudes();
+    // reduce the bins [first, last) to the display resolution,
+    //   the maximum of each group is used to keep the peaks visible
+    // @param last 0 for all bins
+    std::vector<P> decimate(uint32_t displayBins, uint32_t first = 0u, uint32_t last = 0u);
+    // the frequency resolution for the given sample rate
+    double getBinWidth(double rate);
+    uint32_t getSize();
+    uint32_t getBins();
+    uint32_t getThreads();
+    double getScale();
+    void setScale(double scale);
+
+protected:
+    template<typename T>
+    void executeSamples(const ChunkedArray<T>& data, uint32_t channel);
+
+private:
+    uint32_t m_size;
+    uint32_t m_threads;
+    std::shared_ptr<const std::vector<P>> m_window;
+    P* m_input{};
+    typename FftwApi<P>::complex* m_result{};
+    typename FftwApi<P>::plan m_plan{};
+    std::vector<P> m_magnitudes;
+    double m_scale{1.0};
+    double m_windowGain;    // as FftEngine::getAddScale
+};
+
+// constant Q analysis with musically spaced bins (e.g. one per semitone),
+//   as in Brown, Puckette "An efficient algorithm for the calculation of a constant Q transform":
+//   the spectral kernel of each bin is computed once and only the values above
+//   KERNEL_THRESHOLD are kept, so each frame is one fft and a few products per bin.
+//   The fft has to cover the longest (lowest) kernel, so the most recent samples are kept
+// @param T the sample type
+template <typename T, typename P = double>
+class FftConstantQ
+{
+public:
+    // @param minFreq the frequency of the first bin (55Hz is A1)
+    FftConstantQ(uint32_t channels, double rate, double minFreq = 55.0, double maxFreq = 7040.0, uint32_t binsPerOctave = 12u);
+    explicit FftConstantQ(const FftConstantQ& orig) = delete;
+    virtual ~FftConstantQ();
+    // add the samples and analyze the most recent fft size frames
+    // @param channel select the channel to analyze, or CHANNEL_MID for the stereo mid signal
+    // @return true if the bins were updated (enough samples)
+    bool push(const ChunkedArray<T>& data, uint32_t channel = 0u);
+    // the magnitudes of the bins, a sine gives its amplitude
+    const std::vector<P>& getValues();
+    // map the bins to cnt tiles for display, the maximum if multiple bins go into one tile
+    void adjust(std::vector<float>& fout, size_t cnt, double factor = 1.0);
+    double getFrequency(size_t bin);
+    size_t getBinCount();
+    uint32_t getFftSize();
+    // the kernel values kept
+    size_t getKernelSize();
+    // the time the last frame took in us
+    double getFrameTime();
+    double getScale();
+    void setScale(double scale);
+    void reset();
+    static constexpr double KERNEL_THRESHOLD{0.0054};
+
+protected:
+    void createKernel(double rate, double q);
 
-    const std::shared_ptr<WindowFunction<windowSize>> m_windowFunction;
+private:
+    double m_minFreq;
+    uint32_t m_binsPerOctave;
+    uint32_t m_fftSize;
+    ChunkedArray<T> m_pending;
+    P* m_input{};
+    typename FftwApi<P>::complex* m_result{};
+    typename FftwApi<P>::plan m_plan{};
+    std::vector<uint32_t> m_first;      // the first fft bin of each kernel
+    std::vector<uint32_t> m_offsets;    // bin k has the kernel values [m_offsets[k], m_offsets[k + 1])
+    std::vector<P> m_kernel;            // conjugated, interleaved re, im
+    std::vector<P> m_values;
+    double m_frameTime{};
     double m_scale{1.0};
 };
 
+// the fixed size variant with any window function
+template <uint32_t windowSize = 2048u, typename P = double>
+class Fft
+: public FftEngine<P>
+{
+public:
+    Fft(const std::shared_ptr<WindowFunction<windowSize>>& windowFunction);
+    explicit Fft(const Fft& orig) = delete;
+    virtual ~Fft() = default;
+    // @param channel select the channel to analyze, or CHANNEL_MID for the stereo mid signal
+    std::shared_ptr<Spectrum<windowSize, P>> execute(const ChunkedArray<int16_t>& data, uint32_t channel = 0u);
+    std::shared_ptr<Spectrum<windowSize, P>> execute(const ChunkedArray<float>& data, uint32_t channel = 0u);
+    // the execute into a (reused) Spectrum
+    using FftEngine<P>::execute;
+    static constexpr uint32_t BINS{windowSize / 2u + 1u};
+
+protected:
+    static std::shared_ptr<const std::vector<P>> createWindow(const std::shared_ptr<WindowFunction<windowSize>>& windowFunction);
+};
+
 
 class Fft512
 : public Fft<512u>
@@ -253,3 +1017,30 @@ public:
     virtual ~Fft2k1k() = default;
 
 };
+
+// single precision variants
+class Fft512f
+: public Fft<512u, float>
+{
+public:
+    Fft512f()
+    : Fft{std::make_shared<HammingWindow512>()}
+    {
+    }
+    explicit Fft512f(const Fft512f& orig) = delete;
+    virtual ~Fft512f() = default;
+
+};
+
+class Fft2kf
+: public Fft<2048u, float>
+{
+public:
+    Fft2kf()
+    : Fft{std::make_shared<HammingWindow2k>()}
+    {
+    }
+    explicit Fft2kf(const Fft2kf& orig) = delete;
+    virtual ~Fft2kf() = default;
+
+};
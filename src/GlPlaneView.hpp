@@ -59,6 +59,9 @@ public:
     static constexpr auto MOVE_FORWARD = "F";
     static constexpr auto FREQ_LINEAR = "L";
     static constexpr auto FREQ_LOGARITHMIC = "O";
+    static constexpr auto FREQ_MEL = "M";
+    static constexpr auto FREQ_BARK = "B";
+    static constexpr auto FREQ_NOTES = "N";
 protected:
     static constexpr auto USE_TRANSPARENCY{true};
     void doActivateModel();
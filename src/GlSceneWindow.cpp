@@ -69,14 +69,14 @@ PlotAudio::~PlotAudio()
 }
 
 void
-PlotAudio::notifyAudio(const std::vector<double>& values)
+PlotAudio::notifyAudio(std::span<const float> values)
 {
     if (m_plotDrawing && m_plotDrawing->isActive()) {
 #       ifdef DEBUG
         std::cout << "PlotAudio::notifyAudio " << values.size() << std::endl;
 #       endif
         m_hzPerSlot = m_upperFreq / static_cast<double>(values.size());
-        m_values = values;
+        m_values.assign(values.begin(), values.end());    // keeps the capacity
         m_plotDrawing->getXAxis().setMinMax(0, static_cast<double>(values.size() - 1));
         m_plotDrawing->refresh();
     }
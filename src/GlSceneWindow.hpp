@@ -36,7 +36,7 @@ public:
     explicit PlotAudio(const PlotAudio& orig) = delete;
     virtual ~PlotAudio();
 
-    void notifyAudio(const std::vector<double>& values);
+    void notifyAudio(std::span<const float> values) override;
 
     static constexpr auto MARK_HZ{2000.0};
     Glib::ustring getLabel(size_t idx);
@@ -67,6 +67,13 @@ public:
     static constexpr auto KEEP_SUM_KEY{"keepSum"};
     static constexpr auto FREQ_USE_KEY{"frequUsage"};
     static constexpr auto FREQ_SCALE_MODE_KEY{"frequScaleMode"};
+    static constexpr auto FFT_PLANNING_KEY{"fftPlanning"};
+    static constexpr auto FFT_SIZE_KEY{"fftSize"};
+    static constexpr auto FFT_OVERLAP_KEY{"fftOverlap"};
+    static constexpr auto FFT_WINDOW_KEY{"fftWindow"};
+    static constexpr auto LEVEL_GAIN_KEY{"levelGain"};
+    static constexpr auto LEVEL_DECIBEL_KEY{"levelDecibel"};
+    static constexpr auto SMOOTHING_KEY{"smoothing"};
     static constexpr auto MOVEMENT_KEY{"movement"};
     static constexpr auto MODEL_FILE_KEY{"modelFile"};
     static constexpr auto MODEL_ANIM_SPEED{"modelAnimSpeed"};
@@ -0,0 +1,251 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "MappedFile.hpp"
+
+MappedFile::MappedFile(const std::string& path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw PcmException("MappedFile open " + path + " " + std::strerror(errno));
+    }
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        auto err = errno;
+        ::close(fd);
+        throw PcmException("MappedFile stat " + path + " " + std::strerror(err));
+    }
+    m_size = static_cast<size_t>(st.st_size);
+    if (m_size > 0) {
+        void* map = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            auto err = errno;
+            ::close(fd);
+            throw PcmException("MappedFile map " + path + " " + std::strerror(err));
+        }
+        m_data = static_cast<uint8_t*>(map);
+        advise(0, m_size, MADV_SEQUENTIAL);
+    }
+    ::close(fd);    // the mapping keeps the file
+}
+
+MappedFile::~MappedFile()
+{
+    if (m_data) {
+        ::munmap(m_data, m_size);
+        m_data = nullptr;
+    }
+}
+
+const uint8_t*
+MappedFile::getData() const
+{
+    return m_data;
+}
+
+size_t
+MappedFile::getSize() const
+{
+    return m_size;
+}
+
+void
+MappedFile::advise(size_t offset, size_t length, int advice)
+{
+    // madvise requires a page aligned start
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    auto start = offset / page * page;
+    auto end = std::min(offset + length, m_size);
+    if (m_data && start < end) {
+        if (::madvise(m_data + start, end - start, advice) != 0) {
+            std::cout << "MappedFile::advise " << advice << " " << std::strerror(errno) << std::endl;
+        }
+    }
+}
+
+void
+MappedFile::release(size_t offset)
+{
+    const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    auto end = std::min(offset, m_size) / page * page;   // keep the page offset is in
+    if (m_data && end > 0) {
+        ::madvise(m_data, end, MADV_DONTNEED);
+    }
+}
+
+// the values we need from wav header
+static uint32_t
+readLe32(const uint8_t* p)
+{
+    return static_cast<uint32_t>(p[0])
+         | static_cast<uint32_t>(p[1]) << 8
+         | static_cast<uint32_t>(p[2]) << 16
+         | static_cast<uint32_t>(p[3]) << 24;
+}
+
+static uint16_t
+readLe16(const uint8_t* p)
+{
+    return static_cast<uint16_t>(p[0] | p[1] << 8);
+}
+
+template<typename T>
+struct WavFormat;
+
+template<>
+struct WavFormat<int16_t>
+{
+    static constexpr uint16_t format{1u};   // pcm
+};
+
+template<>
+struct WavFormat<float>
+{
+    static constexpr uint16_t format{3u};   // ieee float
+};
+
+template<typename T>
+PcmFile<T>::PcmFile(const std::string& path, uint32_t rawChannels, uint32_t rawSampleRate)
+: m_file{std::make_shared<MappedFile>(path)}
+, m_channels{rawChannels}
+, m_sampleRate{rawSampleRate}
+, m_dataSize{m_file->getSize()}
+{
+    auto data = m_file->getData();
+    if (m_file->getSize() >= 12
+     && std::memcmp(data, "RIFF", 4) == 0
+     && std::memcmp(data + 8, "WAVE", 4) == 0) {
+        parseWav();
+    }
+    // e.g. a float wav with fact chunk has its data at 58, these are copied
+    m_aligned = reinterpret_cast<uintptr_t>(data + m_dataOffset) % alignof(T) == 0;
+}
+
+template<typename T>
+void
+PcmFile<T>::parseWav()
+{
+    auto data = m_file->getData();
+    const auto size = m_file->getSize();
+    bool hasFormat{false};
+    size_t pos{12};
+    while (pos + 8 <= size) {
+        auto id = data + pos;
+        size_t len = readLe32(data + pos + 4);
+        pos += 8;
+        if (std::memcmp(id, "fmt ", 4) == 0 && len >= 16 && pos + len <= size) {
+            auto format = readLe16(data + pos);
+            if (format == 0xfffeu && len >= 26) {   // extensible, use sub format
+                format = readLe16(data + pos + 24);
+            }
+            m_channels = readLe16(data + pos + 2);
+            m_sampleRate = readLe32(data + pos + 4);
+            auto bits = readLe16(data + pos + 14);
+            if (format != WavFormat<T>::format || bits != sizeof(T) * 8u) {
+                throw PcmException("PcmFile wav format " + std::to_string(format)
+                                 + " bits " + std::to_string(bits) + " does not match the sample type");
+            }
+            if (m_channels == 0) {
+                throw PcmException("PcmFile wav without channels");
+            }
+            hasFormat = true;
+        }
+        else if (std::memcmp(id, "data", 4) == 0) {
+            if (!hasFormat) {
+                throw PcmException("PcmFile wav data before format");
+            }
+            m_dataOffset = pos;
+            m_dataSize = std::min(len, size - pos);   // recordings that were aborted may be truncated
+            return;
+        }
+        pos += len + (len & 1u);    // chunks are word aligned
+    }
+    throw PcmException("PcmFile wav without data");
+}
+
+template<typename T>
+ChunkedArray<T>
+PcmFile<T>::getArray(size_t chunkSamples)
+{
+    ChunkedArray<T> array{m_channels};
+    auto bytes = m_file->getData() + m_dataOffset;
+    const size_t count = getSamples();
+    // keep the chunks to complete frames
+    chunkSamples = std::max(chunkSamples / m_channels, static_cast<size_t>(1u)) * m_channels;
+    for (size_t pos = 0; pos < count; pos += chunkSamples) {
+        const auto len = std::min(chunkSamples, count - pos);
+        if (m_aligned) {
+            array.add(std::span<const T>(reinterpret_cast<const T*>(bytes) + pos, len), m_file);
+        }
+        else {
+            // the samples can't be accessed in place, copy them and drop the mapped pages
+            auto chunk = std::make_shared<std::vector<T>>(len);
+            std::memcpy(chunk->data(), bytes + pos * sizeof(T), len * sizeof(T));
+            array.add(chunk);
+            m_file->release(m_dataOffset + (pos + len) * sizeof(T));
+        }
+    }
+    return array;
+}
+
+template<typename T>
+uint32_t
+PcmFile<T>::getChannels()
+{
+    return m_channels;
+}
+
+template<typename T>
+uint32_t
+PcmFile<T>::getSampleRate()
+{
+    return m_sampleRate;
+}
+
+template<typename T>
+bool
+PcmFile<T>::isMapped()
+{
+    return m_aligned;
+}
+
+template<typename T>
+size_t
+PcmFile<T>::getSamples()
+{
+    return m_dataSize / sizeof(T);
+}
+
+template<typename T>
+void
+PcmFile<T>::release(size_t sample)
+{
+    m_file->release(m_dataOffset + sample * sizeof(T));
+}
+
+template class PcmFile<int16_t>;
+template class PcmFile<float>;
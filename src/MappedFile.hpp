@@ -0,0 +1,95 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4;  coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <memory>
+#include <stdexcept>
+#include <cstdint>
+
+#include "ChunkedArray.hpp"
+
+class PcmException
+: public std::runtime_error
+{
+public:
+    PcmException(const std::string& error)
+    : std::runtime_error(error)
+    {
+    }
+};
+
+// a file mapped read only into memory (posix only)
+class MappedFile
+{
+public:
+    MappedFile(const std::string& path);
+    explicit MappedFile(const MappedFile& orig) = delete;
+    virtual ~MappedFile();
+
+    const uint8_t* getData() const;
+    size_t getSize() const;
+    // hint the kernel how a range will be used (e.g. MADV_WILLNEED)
+    void advise(size_t offset, size_t length, int advice);
+    // the pages before offset are not needed anymore,
+    //   as they are file backed they will be read again if accessed
+    void release(size_t offset);
+private:
+    uint8_t* m_data{};
+    size_t m_size{};
+};
+
+// pcm data from a wav or raw file, as ChunkedArray
+//   the chunks reference the mapped pages, so there is no copy.
+//   The mapping is advised as sequential, so the pages get read ahead
+//   and may be dropped after being read, this keeps the resident memory bounded
+//   for long inputs (use release to force this).
+//   If the data is not aligned for T (e.g. float after a fact chunk)
+//   the chunks are copied instead.
+template<typename T>
+class PcmFile
+{
+public:
+    // @param rawChannels the channels if this is no wav file
+    PcmFile(const std::string& path, uint32_t rawChannels = 1u, uint32_t rawSampleRate = 44100u);
+    explicit PcmFile(const PcmFile& orig) = delete;
+    virtual ~PcmFile() = default;
+
+    // @param chunkSamples the samples for each chunk of the array
+    ChunkedArray<T> getArray(size_t chunkSamples = DEFAULT_CHUNK_SAMPLES);
+    uint32_t getChannels();
+    uint32_t getSampleRate();
+    size_t getSamples();
+    // false if the data is not aligned for T and getArray copies
+    bool isMapped();
+    // the samples before sample are not needed anymore
+    void release(size_t sample);
+
+    static constexpr size_t DEFAULT_CHUNK_SAMPLES{256u * 1024u};
+protected:
+    void parseWav();
+
+private:
+    std::shared_ptr<MappedFile> m_file;
+    uint32_t m_channels;
+    uint32_t m_sampleRate;
+    size_t m_dataOffset{};
+    size_t m_dataSize{};
+    bool m_aligned{true};
+};
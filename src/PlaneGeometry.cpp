@@ -16,6 +16,8 @@
  */
 
 #include <iostream>
+#include <algorithm>
+#include <cstdlib>
 
 #include "PlaneGeometry.hpp"
 #include "PlaneContext.hpp"
@@ -28,6 +30,8 @@ PlaneGeometry::PlaneGeometry(PlaneContext *_ctx, const std::shared_ptr<KeyConfig
 , lastms{}
 {
     //std::cout << "n: " << n << " n²: " << n*n << std::endl;
+    m_level.setTarget(Row::MAX_Y);      // the automatic gain keeps to the displayable range
+    m_level.setReference(Row::MAX_Y);   // the tiles are scaled to the display already
     restoreConfig();
 }
 
@@ -86,6 +90,8 @@ void
 PlaneGeometry::setScaleMode(const std::string& scaleMode)
 {
     m_scaleMode = scaleMode;
+    SpectrumMapping::clear();   // the previous mappings are not used anymore
+    m_constantQ.reset();        // keeps no stale samples, the kernel is built again when needed
 }
 
 double
@@ -98,6 +104,93 @@ void
 PlaneGeometry::setAudioUsageRate(double useRate)
 {
     m_audioUsageRate = useRate;
+    SpectrumMapping::clear();
+}
+
+std::string
+PlaneGeometry::getFftPlanning()
+{
+    return FftPlanner::toId(FftPlanner::getPlanning());
+}
+
+void
+PlaneGeometry::setFftPlanning(const std::string& planning)
+{
+    auto fftPlanning = FftPlanner::fromId(planning);
+    // the plans are made on the gui thread, patient may take seconds for a size,
+    //   so keep it for offline use (e.g. a stored "P" plans with measure)
+    if (fftPlanning == FftPlanning::Patient) {
+        fftPlanning = FftPlanning::Measure;
+    }
+    if (fftPlanning != FftPlanner::getPlanning()) {
+        FftPlanner::setPlanning(fftPlanning);
+        m_fft.reset();      // plan again with the new effort on next use
+    }
+}
+
+std::string
+PlaneGeometry::getFftSize()
+{
+    return std::to_string(m_fftSize);
+}
+
+void
+PlaneGeometry::setFftSize(const std::string& size)
+{
+    auto value = std::strtoul(size.c_str(), nullptr, 10);
+    // keep to the powers of two the preferences offer, these are the fast ones
+    //   and larger sizes would take long to plan (on the gui thread)
+    auto fftSize = FFT_SIZE_DEFAULT;
+    if (value >= FFT_SIZE_MIN
+     && value <= FFT_SIZE_MAX
+     && (value & (value - 1u)) == 0u) {
+        fftSize = static_cast<uint32_t>(value);
+    }
+    if (fftSize != m_fftSize) {
+        m_fftSize = fftSize;
+        m_fft.reset();      // the plans are cached, switching back is cheap
+        SpectrumMapping::clear();
+    }
+}
+
+std::string
+PlaneGeometry::getFftOverlap()
+{
+    return std::to_string(m_fftOverlap);
+}
+
+void
+PlaneGeometry::setFftOverlap(const std::string& overlap)
+{
+    auto value = std::strtoul(overlap.c_str(), nullptr, 10);
+    // keep to the overlaps the preferences offer, the hop shall divide the window
+    auto fftOverlap = 1u;
+    if (value == 2u
+     || value == 4u) {
+        fftOverlap = static_cast<uint32_t>(value);
+    }
+    if (fftOverlap != m_fftOverlap) {
+        m_fftOverlap = fftOverlap;
+        if (m_fft) {
+            m_fft->setHopSize(m_fftSize / m_fftOverlap);
+        }
+    }
+}
+
+std::string
+PlaneGeometry::getFftWindow()
+{
+    return FftWindows::toId(m_fftWindow);
+}
+
+void
+PlaneGeometry::setFftWindow(const std::string& window)
+{
+    auto fftWindow = FftWindows::fromId(window);
+    if (fftWindow != m_fftWindow) {
+        m_fftWindow = fftWindow;
+        m_fft.reset();      // the window tables are cached as well
+    }
 }
 
 void
@@ -107,6 +200,13 @@ PlaneGeometry::saveConfig()
     m_keyConfig->setBoolean(GlSceneWindow::MAIN_SECTION, GlSceneWindow::KEEP_SUM_KEY, isKeepSum());
     m_keyConfig->setDouble(GlSceneWindow::MAIN_SECTION, GlSceneWindow::FREQ_USE_KEY, getAudioUsageRate());
     m_keyConfig->setString(GlSceneWindow::MAIN_SECTION, GlSceneWindow::FREQ_SCALE_MODE_KEY, getScaleMode());
+    m_keyConfig->setString(GlSceneWindow::MAIN_SECTION, GlSceneWindow::FFT_PLANNING_KEY, getFftPlanning());
+    m_keyConfig->setString(GlSceneWindow::MAIN_SECTION, GlSceneWindow::FFT_SIZE_KEY, getFftSize());
+    m_keyConfig->setString(GlSceneWindow::MAIN_SECTION, GlSceneWindow::FFT_OVERLAP_KEY, getFftOverlap());
+    m_keyConfig->setString(GlSceneWindow::MAIN_SECTION, GlSceneWindow::FFT_WINDOW_KEY, getFftWindow());
+    m_keyConfig->setString(GlSceneWindow::MAIN_SECTION, GlSceneWindow::LEVEL_GAIN_KEY, getLevelGain());
+    m_keyConfig->setBoolean(GlSceneWindow::MAIN_SECTION, GlSceneWindow::LEVEL_DECIBEL_KEY, isLevelDecibel());
+    m_keyConfig->setString(GlSceneWindow::MAIN_SECTION, GlSceneWindow::SMOOTHING_KEY, getSmoothing());
 }
 
 
@@ -117,13 +217,22 @@ PlaneGeometry::restoreConfig()
     setKeepSum(m_keyConfig->getBoolean(GlSceneWindow::MAIN_SECTION, GlSceneWindow::KEEP_SUM_KEY, false));
     setAudioUsageRate(m_keyConfig->getDouble(GlSceneWindow::MAIN_SECTION, GlSceneWindow::FREQ_USE_KEY, 0.5));
     setScaleMode(m_keyConfig->getString(GlSceneWindow::MAIN_SECTION, GlSceneWindow::FREQ_SCALE_MODE_KEY, GlPlaneView::FREQ_LINEAR));
+    setFftPlanning(m_keyConfig->getString(GlSceneWindow::MAIN_SECTION, GlSceneWindow::FFT_PLANNING_KEY, FftPlanner::PLANNING_MEASURE));
+    setFftSize(m_keyConfig->getString(GlSceneWindow::MAIN_SECTION, GlSceneWindow::FFT_SIZE_KEY, std::to_string(FFT_SIZE_DEFAULT)));
+    setFftOverlap(m_keyConfig->getString(GlSceneWindow::MAIN_SECTION, GlSceneWindow::FFT_OVERLAP_KEY, "1"));
+    setFftWindow(m_keyConfig->getString(GlSceneWindow::MAIN_SECTION, GlSceneWindow::FFT_WINDOW_KEY, FftWindows::WINDOW_HAMMING));
+    setLevelGain(m_keyConfig->getString(GlSceneWindow::MAIN_SECTION, GlSceneWindow::LEVEL_GAIN_KEY, SpectrumLevel<float>::GAIN_FIXED));
+    setLevelDecibel(m_keyConfig->getBoolean(GlSceneWindow::MAIN_SECTION, GlSceneWindow::LEVEL_DECIBEL_KEY, false));
+    setSmoothing(m_keyConfig->getString(GlSceneWindow::MAIN_SECTION, GlSceneWindow::SMOOTHING_KEY, SpectrumSmoothing<float>::SMOOTHING_OFF));
 }
 
-std::vector<double>
+std::span<const float>
 PlaneGeometry::getAudioAsArray()
 {
-    std::vector<double> ret = m_spec->getVector();
-    return ret;
+    if (!m_spec) {
+        return {};
+    }
+    return m_spec->getValues();
 }
 
 std::shared_ptr<psc::snd::PulseCtx>
@@ -140,34 +249,103 @@ PlaneGeometry::getZat(float index)
     return z;
 }
 
-std::vector<float>
+std::string
+PlaneGeometry::getLevelGain()
+{
+    return SpectrumLevel<float>::toId(m_level.getGain());
+}
+
+void
+PlaneGeometry::setLevelGain(const std::string& gain)
+{
+    m_level.setGain(SpectrumLevel<float>::fromId(gain));
+}
+
+bool
+PlaneGeometry::isLevelDecibel()
+{
+    return m_level.isDecibel();
+}
+
+void
+PlaneGeometry::setLevelDecibel(bool decibel)
+{
+    m_level.setDecibel(decibel);
+}
+
+std::string
+PlaneGeometry::getSmoothing()
+{
+    return SpectrumSmoothing<float>::toId(m_smoothing.getMode());
+}
+
+void
+PlaneGeometry::setSmoothing(const std::string& smoothing)
+{
+    m_smoothing.setMode(SpectrumSmoothing<float>::fromId(smoothing));
+}
+
+const std::vector<float>&
 PlaneGeometry::buildValues()
 {
-    std::vector<float> values;
     if (!m_pulseCtx) {
         Glib::RefPtr<Glib::MainContext> ctx = Glib::MainContext::get_default();
         m_pulseCtx = std::make_shared<psc::snd::PulseCtx>(ctx);
     }
     if (!m_pulseIn) {
         psc::snd::PulseFormat fmt;
-        m_pulseIn = std::make_shared<psc::snd::PulseIn>(m_pulseCtx, fmt);
+        m_pulseIn = std::make_shared<psc::snd::PulseInFloat>(m_pulseCtx, fmt);
+        m_sampleRate = static_cast<double>(fmt.samplePerSec);
     }
+    auto& data = m_pulseIn->read();
     if (!m_fft) {
-        m_fft = std::make_shared<Fft512>();
+        // float is sufficient for display,
+        //   the stream keeps the samples of incomplete windows for the next read
+        m_fft = std::make_shared<FftStream<float, float>>(data.getChannels(), m_fftSize, m_fftSize / m_fftOverlap, m_fftWindow);
         //m_fft->calibrate(1.0);
+        m_spec = std::make_shared<SpectrumBase<float>>(m_fftSize);     // reused for each push
+        m_smoothing.resize(m_spec->getSum().size());
+    }
+    // keeps the previous spectrum, if the read did not complete a window
+    if (m_fft->push(data, *m_spec)) {
+        // smooth the new spectrum only, so this is independent of the read rate
+        auto now = std::chrono::steady_clock::now();
+        m_smoothing.process(m_spec->getSum(), std::chrono::duration_cast<std::chrono::duration<double>>(now - m_lastSpectrum).count());
+        m_lastSpectrum = now;
     }
-    auto data = m_pulseIn->read();
-    m_spec = m_fft->execute(data);
     if (m_audioListener) {
-        m_audioListener->notifyAudio(m_spec->getVector());
+        m_audioListener->notifyAudio(m_spec->getValues());
     }
     if (m_scaleMode == GlPlaneView::FREQ_LOGARITHMIC) {
-        values = m_spec->adjustLog(PLANE_TILES, m_audioUsageRate, m_scale, m_keepSum);
+        m_spec->adjustLog(m_values, PLANE_TILES, m_audioUsageRate, m_scale, m_keepSum);
+    }
+    else if (m_scaleMode == GlPlaneView::FREQ_MEL) {
+        m_spec->adjustFilterbank(m_values, PLANE_TILES, m_audioUsageRate, m_sampleRate, SpectrumScale::Mel, m_scale, m_keepSum);
+    }
+    else if (m_scaleMode == GlPlaneView::FREQ_BARK) {
+        m_spec->adjustFilterbank(m_values, PLANE_TILES, m_audioUsageRate, m_sampleRate, SpectrumScale::Bark, m_scale, m_keepSum);
+    }
+    else if (m_scaleMode == GlPlaneView::FREQ_NOTES) {
+        if (!m_constantQ) {
+            // one bin per semitone, the kernel is computed once
+            m_constantQ = std::make_shared<FftConstantQ<float, float>>(data.getChannels(), m_sampleRate);
+        }
+        m_constantQ->push(data);
+        m_constantQ->adjust(m_values, PLANE_TILES, m_scale);
+#       ifdef DEBUG
+        std::cout << "PlaneGeometry::buildValues"
+                  << " kernel " << m_constantQ->getKernelSize()
+                  << " frame " << m_constantQ->getFrameTime() << "us" << std::endl;
+#       endif
     }
     else {
-        values = m_spec->adjustLin(PLANE_TILES, m_audioUsageRate, m_scale, m_keepSum);
+        m_spec->adjustLin(m_values, PLANE_TILES, m_audioUsageRate, m_scale, m_keepSum);
     }
-    return values;
+    // the fixed linear level keeps the values as they are
+    auto now = std::chrono::steady_clock::now();
+    m_level.process(m_values, std::chrono::duration_cast<std::chrono::duration<double>>(now - m_lastValues).count());
+    m_lastValues = now;
+    return m_values;
 }
 
 void
@@ -221,7 +399,7 @@ ForwardPlaneGeometry::advance(gint64 time)
         auto pRow = psc::mem::make_active<Row>(ctx, PLANE_TILES);
         if (auto lRow = pRow.lease())  {
             float zp = getZat(0.0f);
-            auto values = buildValues();
+            auto& values = buildValues();
             lRow->build(m_backRow, zp, Z_MIN, step, step, values);
         }
         m_backRow = pRow;
@@ -334,7 +512,7 @@ BackwardPlaneGeometry::advance(gint64 time)
         auto pRow = psc::mem::make_active<Row>(ctx, PLANE_TILES);
         if (auto lRow = pRow.lease())  {
             float zp = getZat(0.0f);    // we will reposition so this does not matter
-            auto values = buildValues();
+            auto& values = buildValues();
             lRow->build(m_frontRow, zp, Z_MIN, step, -step, values);
         }
         m_frontRow = pRow;
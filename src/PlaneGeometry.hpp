@@ -20,18 +20,22 @@
 #include <gtkmm.h>
 #include <GenericGlmCompat.hpp>
 #include <list>
+#include <span>
+#include <chrono>
 #include <Geom2.hpp>
 #include <KeyConfig.hpp>
 
 #include "PlaneContext.hpp"
 #include "Row.hpp"
 #include "Fft.hpp"
+#include "SpectrumStage.hpp"
 #include "Pulse.hpp"
 
 class AudioListener
 {
 public:
-    virtual void notifyAudio(const std::vector<double>& fft) = 0;
+    // the spectrum is only valid during the call
+    virtual void notifyAudio(std::span<const float> fft) = 0;
 };
 
 class PlaneGeometry
@@ -61,29 +65,62 @@ public:
     void setScaleMode(const std::string& scaleMode);
     double getAudioUsageRate();
     void setAudioUsageRate(double useRate);
+    std::string getFftPlanning();
+    void setFftPlanning(const std::string& planning);
+    // as string to use it with ids
+    std::string getFftSize();
+    void setFftSize(const std::string& size);
+    // windows overlapping, 1 no overlap, 2 50%...
+    std::string getFftOverlap();
+    void setFftOverlap(const std::string& overlap);
+    std::string getFftWindow();
+    void setFftWindow(const std::string& window);
+    // the automatic gain, see SpectrumLevel
+    std::string getLevelGain();
+    void setLevelGain(const std::string& gain);
+    bool isLevelDecibel();
+    void setLevelDecibel(bool decibel);
+    // the temporal smoothing of the spectrum, see SpectrumSmoothing
+    std::string getSmoothing();
+    void setSmoothing(const std::string& smoothing);
+    static constexpr auto FFT_SIZE_DEFAULT{512u};
+    static constexpr auto FFT_SIZE_MIN{256u};
+    static constexpr auto FFT_SIZE_MAX{8192u};
     void saveConfig();
     void restoreConfig();
-    std::vector<double> getAudioAsArray();
+    // valid until the next row is built
+    std::span<const float> getAudioAsArray();
     std::shared_ptr<psc::snd::PulseCtx> getPulseContext();
     void addAudioListener(AudioListener* audioListener);
     void removeAudioListener(AudioListener* audioListener);
 protected:
     float getZat(float z);
-    std::vector<float> buildValues();
+    // @return the values for a row, valid until the next call
+    const std::vector<float>& buildValues();
 
     PlaneContext *ctx;
     std::shared_ptr<KeyConfig> m_keyConfig;
     std::list<psc::mem::active_ptr<Row>> rows;
     int32_t lastms;
     gint64 m_startTime{-1l};
-    std::shared_ptr<Fft512> m_fft;
-    std::shared_ptr<Spectrum<512>> m_spec;
+    std::shared_ptr<FftStream<float, float>> m_fft;
+    std::shared_ptr<SpectrumBase<float>> m_spec;
+    std::shared_ptr<FftConstantQ<float, float>> m_constantQ;    // only used for the notes mode
+    std::vector<float> m_values;
     std::shared_ptr<psc::snd::PulseCtx> m_pulseCtx;
-    std::shared_ptr<psc::snd::PulseIn> m_pulseIn;
+    std::shared_ptr<psc::snd::PulseInFloat> m_pulseIn;
     double m_scale{1.0};
     bool m_keepSum{false};
     std::string m_scaleMode;
     double m_audioUsageRate{0.5};
+    double m_sampleRate{44100.0};
+    uint32_t m_fftSize{FFT_SIZE_DEFAULT};
+    uint32_t m_fftOverlap{1u};
+    FftWindowType m_fftWindow{FftWindowType::Hamming};
+    SpectrumLevel<float> m_level;
+    std::chrono::steady_clock::time_point m_lastValues;
+    SpectrumSmoothing<float> m_smoothing;
+    std::chrono::steady_clock::time_point m_lastSpectrum;
     AudioListener* m_audioListener{nullptr};
 };
 
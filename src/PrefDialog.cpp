@@ -58,10 +58,68 @@ PrefDialog::PrefDialog(BaseObjectType* cobject, const Glib::RefPtr<Gtk::Builder>
     builder->get_widget("freqMode", m_freqMode);
     m_freqMode->append(GlPlaneView::FREQ_LINEAR, "Linear");
     m_freqMode->append(GlPlaneView::FREQ_LOGARITHMIC, "Logarithmic");
+    m_freqMode->append(GlPlaneView::FREQ_MEL, "Mel");
+    m_freqMode->append(GlPlaneView::FREQ_BARK, "Bark");
+    m_freqMode->append(GlPlaneView::FREQ_NOTES, "Notes");
     m_freqMode->set_active_id(m_sceneWindow->getPlaneGeometry()->getScaleMode());
     m_freqMode->signal_changed().connect([this] {
         m_sceneWindow->getPlaneGeometry()->setScaleMode(m_freqMode->get_active_id());
     });
+    builder->get_widget("fftPlanning", m_fftPlanning);
+    m_fftPlanning->append(FftPlanner::PLANNING_ESTIMATE, "Estimate");
+    m_fftPlanning->append(FftPlanner::PLANNING_MEASURE, "Measure");
+    m_fftPlanning->set_active_id(m_sceneWindow->getPlaneGeometry()->getFftPlanning());
+    m_fftPlanning->signal_changed().connect([this] {
+        m_sceneWindow->getPlaneGeometry()->setFftPlanning(m_fftPlanning->get_active_id());
+    });
+    builder->get_widget("fftSize", m_fftSize);
+    for (uint32_t size = PlaneGeometry::FFT_SIZE_MIN; size <= PlaneGeometry::FFT_SIZE_MAX; size *= 2u) {
+        auto id = std::to_string(size);
+        m_fftSize->append(id, id);
+    }
+    m_fftSize->set_active_id(m_sceneWindow->getPlaneGeometry()->getFftSize());
+    m_fftSize->signal_changed().connect([this] {
+        m_sceneWindow->getPlaneGeometry()->setFftSize(m_fftSize->get_active_id());
+    });
+    builder->get_widget("fftOverlap", m_fftOverlap);
+    m_fftOverlap->append("1", "None");
+    m_fftOverlap->append("2", "50%");
+    m_fftOverlap->append("4", "75%");
+    m_fftOverlap->set_active_id(m_sceneWindow->getPlaneGeometry()->getFftOverlap());
+    m_fftOverlap->signal_changed().connect([this] {
+        m_sceneWindow->getPlaneGeometry()->setFftOverlap(m_fftOverlap->get_active_id());
+    });
+    builder->get_widget("fftWindow", m_fftWindow);
+    m_fftWindow->append(FftWindows::WINDOW_HAMMING, "Hamming");
+    m_fftWindow->append(FftWindows::WINDOW_HANN, "Hann");
+    m_fftWindow->append(FftWindows::WINDOW_BLACKMAN_HARRIS, "Blackman-Harris");
+    m_fftWindow->append(FftWindows::WINDOW_FLAT_TOP, "Flat top");
+    m_fftWindow->append(FftWindows::WINDOW_KAISER, "Kaiser");
+    m_fftWindow->set_active_id(m_sceneWindow->getPlaneGeometry()->getFftWindow());
+    m_fftWindow->signal_changed().connect([this] {
+        m_sceneWindow->getPlaneGeometry()->setFftWindow(m_fftWindow->get_active_id());
+    });
+    builder->get_widget("levelGain", m_levelGain);
+    m_levelGain->append(SpectrumLevel<float>::GAIN_FIXED, "Fixed");
+    m_levelGain->append(SpectrumLevel<float>::GAIN_PEAK, "Auto peak");
+    m_levelGain->append(SpectrumLevel<float>::GAIN_PERCENTILE, "Auto percentile");
+    m_levelGain->set_active_id(m_sceneWindow->getPlaneGeometry()->getLevelGain());
+    m_levelGain->signal_changed().connect([this] {
+        m_sceneWindow->getPlaneGeometry()->setLevelGain(m_levelGain->get_active_id());
+    });
+    builder->get_widget("levelDecibel", m_levelDecibel);
+    m_levelDecibel->set_active(m_sceneWindow->getPlaneGeometry()->isLevelDecibel());
+    m_levelDecibel->signal_toggled().connect([this] {
+        m_sceneWindow->getPlaneGeometry()->setLevelDecibel(m_levelDecibel->get_active());
+    });
+    builder->get_widget("smoothing", m_smoothing);
+    m_smoothing->append(SpectrumSmoothing<float>::SMOOTHING_OFF, "Off");
+    m_smoothing->append(SpectrumSmoothing<float>::SMOOTHING_SMOOTH, "Smooth");
+    m_smoothing->append(SpectrumSmoothing<float>::SMOOTHING_PEAK_HOLD, "Peak hold");
+    m_smoothing->set_active_id(m_sceneWindow->getPlaneGeometry()->getSmoothing());
+    m_smoothing->signal_changed().connect([this] {
+        m_sceneWindow->getPlaneGeometry()->setSmoothing(m_smoothing->get_active_id());
+    });
     builder->get_widget("movement", m_movement);
     m_movement->append(GlPlaneView::MOVE_FORWARD, "Forward");
     m_movement->append(GlPlaneView::MOVE_BACKWARD, "Backward");
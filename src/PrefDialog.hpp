@@ -48,6 +48,13 @@ private:
     Gtk::Scale* m_volume;
     Gtk::Scale* m_freqUsage;
     Gtk::ComboBoxText* m_freqMode;
+    Gtk::ComboBoxText* m_fftPlanning;
+    Gtk::ComboBoxText* m_fftSize;
+    Gtk::ComboBoxText* m_fftOverlap;
+    Gtk::ComboBoxText* m_fftWindow;
+    Gtk::ComboBoxText* m_levelGain;
+    Gtk::CheckButton* m_levelDecibel;
+    Gtk::ComboBoxText* m_smoothing;
     Gtk::ComboBoxText* m_movement;
     Gtk::FileChooserButton* m_fileChooser;
     Gtk::CheckButton* m_displayModel;
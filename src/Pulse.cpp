@@ -23,6 +23,7 @@
 #include <stdexcept>
 #include <cmath>
 #include <cstdio>
+#include <algorithm>
 #include <psc_format.hpp>
 
 #include "Pulse.hpp"
@@ -48,9 +49,9 @@ pa_stream_read_cb(pa_stream *stream, const size_t /*nbytes*/, void* userdata)
 {
     // Careful when to pa_stream_peek() and pa_stream_drop()!
     // c.f. https://www.freedesktop.org/software/pulseaudio/doxygen/stream_8h.html#ac2838c449cde56e169224d7fe3d00824
-    int16_t *data = nullptr;
+    const void *data = nullptr;
     size_t actualbytes = 0;
-    if (pa_stream_peek(stream, (const void**)&data, &actualbytes) != 0) {
+    if (pa_stream_peek(stream, &data, &actualbytes) != 0) {
         std::cerr << "Failed to peek at stream data" << std::endl;
         return;
     }
@@ -69,7 +70,7 @@ pa_stream_read_cb(pa_stream *stream, const size_t /*nbytes*/, void* userdata)
 
     // process data
     //std::cout << ">> " << actualbytes << " bytes" << std::endl;
-    auto pulse = static_cast<PulseIn*>(userdata);
+    auto pulse = static_cast<PulseCapture*>(userdata);
     pulse->addData(data, actualbytes);
 
     if (pa_stream_drop(stream) != 0) {
@@ -578,7 +579,7 @@ PulseFormat::toSpec()
     return spec;
 }
 
-PulseIn::PulseIn(const std::shared_ptr<PulseCtx>& pulseContext, PulseFormat& format)
+PulseCapture::PulseCapture(const std::shared_ptr<PulseCtx>& pulseContext, PulseFormat& format)
 : PulseStream{pulseContext, format}
 {
     //pulseContext->signal_server_info()
@@ -587,7 +588,7 @@ PulseIn::PulseIn(const std::shared_ptr<PulseCtx>& pulseContext, PulseFormat& for
 }
 
 void
-PulseIn::serverInfo(const pa_server_info *info)
+PulseCapture::serverInfo(const pa_server_info *info)
 {
     pa_sample_spec spec = m_format.toSpec();
     // Use pa_stream_new_with_proplist instead?
@@ -609,18 +610,7 @@ PulseIn::serverInfo(const pa_server_info *info)
 }
 
 void
-PulseIn::addData(int16_t *data, size_t actualbytes)
-{
-    std::vector<int16_t> block;
-    auto ptr = std::make_shared<std::vector<int16_t>>();
-    size_t addsize = actualbytes / sizeof(int16_t);
-    ptr->resize(addsize);
-    std::copy(data, data + addsize, ptr->begin());
-    m_data.push_back(ptr);
-}
-
-void
-PulseIn::onStreamReady()
+PulseCapture::onStreamReady()
 {
     PulseStream::onStreamReady();   // still show infos
 
@@ -648,26 +638,105 @@ PulseIn::onStreamReady()
 }
 
 
-ChunkedArray<int16_t>
-PulseIn::read()
+template<typename T>
+PulseInput<T>::PulseInput(const std::shared_ptr<PulseCtx>& pulseContext, PulseFormat& format)
+: PulseCapture{pulseContext, adaptFormat(format)}
+, m_read{format.channels, m_storage}
 {
-    ChunkedArray<int16_t> read(m_format.channels);
+}
+
+template<typename T>
+PulseFormat&
+PulseInput<T>::adaptFormat(PulseFormat& format)
+{
+    format.format = PulseSample<T>::format;
+    return format;
+}
+
+template<typename T>
+void
+PulseInput<T>::addData(const void *data, size_t actualbytes)
+{
+    // this runs on the audio thread, the pool and queue are allocated up front
+    //   so nothing here allocates or locks, if the reading doesn't keep up the samples are dropped
+    size_t addsize = actualbytes / sizeof(T);
+    auto samples = static_cast<const T*>(data);
+    // keep whole frames, a buffer shall not exceed the pool size
+    const size_t bufferSize = std::max(POOL_BUFFER_SIZE / m_format.channels, static_cast<size_t>(1u)) * m_format.channels;
+    for (size_t pos = 0; pos < addsize; pos += bufferSize) {
+        const auto len = std::min(bufferSize, addsize - pos);
+        auto ptr = m_pool.acquire(len);     // recycled when the analysis released it
+        if (!ptr) {
+            m_dropped.fetch_add(len, std::memory_order_relaxed);
+            continue;
+        }
+        std::copy(samples + pos, samples + pos + len, ptr->begin());
+        if (!m_data.push(ptr)) {
+            m_dropped.fetch_add(len, std::memory_order_relaxed);
+        }
+    }
+}
+
+template<typename T>
+const ChunkedArray<T>&
+PulseInput<T>::read()
+{
+    // as the analysis accesses each sample multiple times use ring storage,
+    //   the samples are copied in, so the pool buffers are released right away
+    if (m_read.getStorage() == ChunkedStorage::Ring) {
+        m_read.drop(m_read.size());     // keeps the allocated ring
+    }
+    else {
+        // the chunks reference the pool buffers until the next read
+        m_read = ChunkedArray<T>(m_format.channels, m_storage);
+        m_read.setCoalesce(m_coalesce);
+    }
     size_t sum{}, cnt{};
     while (true) {
-        auto next = m_data.pop_front();
+        auto next = m_data.pop();
         if (!next) {
             break;
         }
         sum += next->size();
         ++cnt;
-        read.add(next);
+        m_read.add(next);
     }
 #   ifdef DEBUG
-    std::cout << "Pulse::read cnt " << cnt << " sum " << sum << std::endl;
+    std::cout << "Pulse::read cnt " << cnt << " sum " << sum
+              << " chunks " << m_read.getStatistics().chunks
+              << " pool hits " << m_pool.getHits()
+              << " misses " << m_pool.getMisses()
+              << " high water " << m_pool.getHighWater()
+              << " dropped " << getDropped() << std::endl;
 #   endif
-    return read;
+    return m_read;
+}
+
+template<typename T>
+BufferPool<T>&
+PulseInput<T>::getPool()
+{
+    return m_pool;
+}
+
+template<typename T>
+size_t
+PulseInput<T>::getDropped()
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+template<typename T>
+void
+PulseInput<T>::setStorage(ChunkedStorage storage, size_t coalesce)
+{
+    m_storage = storage;
+    m_coalesce = coalesce;
+    m_read = ChunkedArray<T>(m_format.channels, m_storage);    // used from the next read
 }
 
+template class PulseInput<int16_t>;
+template class PulseInput<float>;
 
 
 float
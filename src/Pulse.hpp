@@ -23,9 +23,9 @@
 #include <pulse/pulseaudio.h>
 #include <pulse/glib-mainloop.h>
 
-#include <ConcurrentCollections.hpp>
 
 #include "ChunkedArray.hpp"
+#include "BufferPool.hpp"
 
 namespace psc::snd
 {
@@ -114,25 +114,75 @@ protected:
     std::vector<PulseStreamNotify*> m_streamListener;
 };
 
-class PulseIn
+// the capture part that is independent of the sample type
+class PulseCapture
 : public PulseStream
 {
 public:
-    PulseIn(const std::shared_ptr<PulseCtx>& pulseContext, PulseFormat& format);
-    explicit PulseIn(const PulseIn& orig) = delete;
-    virtual ~PulseIn() = default;
+    PulseCapture(const std::shared_ptr<PulseCtx>& pulseContext, PulseFormat& format);
+    explicit PulseCapture(const PulseCapture& orig) = delete;
+    virtual ~PulseCapture() = default;
 
     void serverInfo(const pa_server_info *info) override;
-    void addData(int16_t *data, size_t actualbytes) ;
+    virtual void addData(const void *data, size_t actualbytes) = 0;
     void onStreamReady() override;
+};
+
+// map the sample type to the pulse format
+template<typename T>
+struct PulseSample;
 
-    ChunkedArray<int16_t> read();
+template<>
+struct PulseSample<int16_t>
+{
+    static constexpr pa_sample_format format{PA_SAMPLE_S16NE};
+};
+
+template<>
+struct PulseSample<float>
+{
+    static constexpr pa_sample_format format{PA_SAMPLE_FLOAT32NE};
+};
 
+template<typename T>
+class PulseInput
+: public PulseCapture
+{
+public:
+    // the sample format of format will be adapted to T
+    PulseInput(const std::shared_ptr<PulseCtx>& pulseContext, PulseFormat& format);
+    explicit PulseInput(const PulseInput& orig) = delete;
+    virtual ~PulseInput() = default;
+
+    void addData(const void *data, size_t actualbytes) override;
+
+    // the data captured since the last read,
+    //   valid until the next read (the ring storage is reused)
+    const ChunkedArray<T>& read();
+    BufferPool<T>& getPool();
+    // the samples that were lost as the reading did not keep up
+    size_t getDropped();
+    // the storage used for read, with chunked storage
+    //   fragments smaller than coalesce are merged into blocks
+    void setStorage(ChunkedStorage storage, size_t coalesce = 0u);
+
+    static constexpr size_t POOL_CAPACITY{64u};
+    static constexpr size_t POOL_BUFFER_SIZE{4096u};
 protected:
-    TListConcurrent<std::shared_ptr<std::vector<int16_t>>> m_data;
+    static PulseFormat& adaptFormat(PulseFormat& format);
 
+    BufferPool<T> m_pool{POOL_CAPACITY, POOL_BUFFER_SIZE};
+    BufferQueue<T> m_data{POOL_CAPACITY};   // there can't be more buffers to queue
+    std::atomic<size_t> m_dropped{};
+    ChunkedStorage m_storage{ChunkedStorage::Ring};
+    size_t m_coalesce{};
+    ChunkedArray<T> m_read;     // the ring keeps its allocation between reads
 };
 
+using PulseIn = PulseInput<int16_t>;
+// capture float samples, this avoids the integer conversion for the analysis
+using PulseInFloat = PulseInput<float>;
+
 class AudioSource
 {
 public:
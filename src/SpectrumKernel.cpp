@@ -0,0 +1,283 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+
+#include "SpectrumKernel.hpp"
+
+// the vector variants are compiled with target attributes,
+//   so no special build flags are needed and the rest keeps running on any cpu
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#   define SPECTRUM_KERNEL_X86
+#   include <immintrin.h>
+#endif
+
+template <typename P>
+static void
+accumulateScalar(const P* complex, P* sum, size_t n, P scale)
+{
+    for (size_t i = 0; i < n; ++i) {
+        const P re = complex[2u * i];
+        const P im = complex[2u * i + 1u];
+        sum[i] += std::sqrt(re * re + im * im) * scale;
+    }
+}
+
+template <typename P>
+static P
+dotScalar(const P* a, const P* b, size_t n)
+{
+    P sum{};
+    for (size_t i = 0; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+#ifdef SPECTRUM_KERNEL_X86
+__attribute__((target("sse2")))
+static double
+dotSse2(const double* a, const double* b, size_t n)
+{
+    __m128d acc = _mm_setzero_pd();
+    size_t i{};
+    for (; i + 2u <= n; i += 2u) {
+        acc = _mm_add_pd(acc, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+    }
+    alignas(16) double lanes[2];
+    _mm_store_pd(lanes, acc);
+    return lanes[0] + lanes[1] + dotScalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("sse2")))
+static float
+dotSse2(const float* a, const float* b, size_t n)
+{
+    __m128 acc = _mm_setzero_ps();
+    size_t i{};
+    for (; i + 4u <= n; i += 4u) {
+        acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + dotScalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static double
+dotAvx2(const double* a, const double* b, size_t n)
+{
+    __m256d acc = _mm256_setzero_pd();
+    size_t i{};
+    for (; i + 4u <= n; i += 4u) {
+        acc = _mm256_add_pd(acc, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+    }
+    alignas(32) double lanes[4];
+    _mm256_store_pd(lanes, acc);
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]) + dotScalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static float
+dotAvx2(const float* a, const float* b, size_t n)
+{
+    __m256 acc = _mm256_setzero_ps();
+    size_t i{};
+    for (; i + 8u <= n; i += 8u) {
+        acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_loadu_ps(a + i), _mm256_loadu_ps(b + i)));
+    }
+    alignas(32) float lanes[8];
+    _mm256_store_ps(lanes, acc);
+    float sum{};
+    for (float lane : lanes) {
+        sum += lane;
+    }
+    return sum + dotScalar(a + i, b + i, n - i);
+}
+
+__attribute__((target("sse2")))
+static void
+accumulateSse2(const double* complex, double* sum, size_t n, double scale)
+{
+    const __m128d vscale = _mm_set1_pd(scale);
+    size_t i{};
+    for (; i + 2u <= n; i += 2u) {
+        __m128d a = _mm_loadu_pd(complex + 2u * i);         // re0 im0
+        __m128d b = _mm_loadu_pd(complex + 2u * i + 2u);    // re1 im1
+        a = _mm_mul_pd(a, a);
+        b = _mm_mul_pd(b, b);
+        __m128d norm = _mm_add_pd(_mm_unpacklo_pd(a, b), _mm_unpackhi_pd(a, b));
+        __m128d acc = _mm_add_pd(_mm_loadu_pd(sum + i), _mm_mul_pd(_mm_sqrt_pd(norm), vscale));
+        _mm_storeu_pd(sum + i, acc);
+    }
+    accumulateScalar(complex + 2u * i, sum + i, n - i, scale);
+}
+
+__attribute__((target("sse2")))
+static void
+accumulateSse2(const float* complex, float* sum, size_t n, float scale)
+{
+    const __m128 vscale = _mm_set1_ps(scale);
+    size_t i{};
+    for (; i + 4u <= n; i += 4u) {
+        __m128 a = _mm_loadu_ps(complex + 2u * i);          // re0 im0 re1 im1
+        __m128 b = _mm_loadu_ps(complex + 2u * i + 4u);     // re2 im2 re3 im3
+        a = _mm_mul_ps(a, a);
+        b = _mm_mul_ps(b, b);
+        __m128 re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+        __m128 im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        __m128 acc = _mm_add_ps(_mm_loadu_ps(sum + i), _mm_mul_ps(_mm_sqrt_ps(_mm_add_ps(re, im)), vscale));
+        _mm_storeu_ps(sum + i, acc);
+    }
+    accumulateScalar(complex + 2u * i, sum + i, n - i, scale);
+}
+
+__attribute__((target("avx2")))
+static void
+accumulateAvx2(const double* complex, double* sum, size_t n, double scale)
+{
+    const __m256d vscale = _mm256_set1_pd(scale);
+    size_t i{};
+    for (; i + 4u <= n; i += 4u) {
+        __m256d a = _mm256_loadu_pd(complex + 2u * i);      // bins 0 1
+        __m256d b = _mm256_loadu_pd(complex + 2u * i + 4u); // bins 2 3
+        a = _mm256_mul_pd(a, a);
+        b = _mm256_mul_pd(b, b);
+        // hadd works by 128 bit lane, giving the bins 0 2 1 3
+        __m256d norm = _mm256_permute4x64_pd(_mm256_hadd_pd(a, b), 0xd8);
+        __m256d acc = _mm256_add_pd(_mm256_loadu_pd(sum + i), _mm256_mul_pd(_mm256_sqrt_pd(norm), vscale));
+        _mm256_storeu_pd(sum + i, acc);
+    }
+    accumulateScalar(complex + 2u * i, sum + i, n - i, scale);
+}
+
+__attribute__((target("avx2")))
+static void
+accumulateAvx2(const float* complex, float* sum, size_t n, float scale)
+{
+    const __m256 vscale = _mm256_set1_ps(scale);
+    size_t i{};
+    for (; i + 8u <= n; i += 8u) {
+        __m256 a = _mm256_loadu_ps(complex + 2u * i);       // bins 0..3
+        __m256 b = _mm256_loadu_ps(complex + 2u * i + 8u);  // bins 4..7
+        a = _mm256_mul_ps(a, a);
+        b = _mm256_mul_ps(b, b);
+        // hadd works by 128 bit lane, giving the bin pairs 01 45 23 67
+        __m256 norm = _mm256_castpd_ps(_mm256_permute4x64_pd(_mm256_castps_pd(_mm256_hadd_ps(a, b)), 0xd8));
+        __m256 acc = _mm256_add_ps(_mm256_loadu_ps(sum + i), _mm256_mul_ps(_mm256_sqrt_ps(norm), vscale));
+        _mm256_storeu_ps(sum + i, acc);
+    }
+    accumulateScalar(complex + 2u * i, sum + i, n - i, scale);
+}
+#endif
+
+template <typename P>
+void
+SpectrumKernel<P>::accumulate(const P* complex, P* sum, size_t n, P scale)
+{
+    static const Kernel kernel = getKernel(getLevel());
+    kernel(complex, sum, n, scale);
+}
+
+template <typename P>
+P
+SpectrumKernel<P>::dot(const P* a, const P* b, size_t n)
+{
+    static const DotKernel kernel = getDotKernel(getLevel());
+    return kernel(a, b, n);
+}
+
+template <typename P>
+typename SpectrumKernel<P>::DotKernel
+SpectrumKernel<P>::getDotKernel(SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::Scalar:
+        return &dotScalar<P>;
+#   ifdef SPECTRUM_KERNEL_X86
+    case SimdLevel::Sse2:
+        if (__builtin_cpu_supports("sse2")) {
+            return static_cast<DotKernel>(&dotSse2);
+        }
+        break;
+    case SimdLevel::Avx2:
+        if (__builtin_cpu_supports("avx2")) {
+            return static_cast<DotKernel>(&dotAvx2);
+        }
+        break;
+#   endif
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+template <typename P>
+typename SpectrumKernel<P>::Kernel
+SpectrumKernel<P>::getKernel(SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::Scalar:
+        return &accumulateScalar<P>;
+#   ifdef SPECTRUM_KERNEL_X86
+    case SimdLevel::Sse2:
+        if (__builtin_cpu_supports("sse2")) {
+            return static_cast<Kernel>(&accumulateSse2);
+        }
+        break;
+    case SimdLevel::Avx2:
+        if (__builtin_cpu_supports("avx2")) {
+            return static_cast<Kernel>(&accumulateAvx2);
+        }
+        break;
+#   endif
+    default:
+        break;
+    }
+    return nullptr;
+}
+
+template <typename P>
+SimdLevel
+SpectrumKernel<P>::getLevel()
+{
+    for (auto level : {SimdLevel::Avx2, SimdLevel::Sse2}) {
+        if (getKernel(level)) {
+            return level;
+        }
+    }
+    return SimdLevel::Scalar;
+}
+
+template <typename P>
+std::string
+SpectrumKernel<P>::toId(SimdLevel level)
+{
+    switch (level) {
+    case SimdLevel::Sse2:
+        return "sse2";
+    case SimdLevel::Avx2:
+        return "avx2";
+    default:
+        return "scalar";
+    }
+}
+
+// need template instantiation
+template class SpectrumKernel<double>;
+template class SpectrumKernel<float>;
@@ -0,0 +1,53 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4;  coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+enum class SimdLevel
+{
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+// the magnitude accumulation of SpectrumBase::add
+//   sum[i] += |complex[i]| * scale, with the complex values interleaved (as fftw_complex).
+//   The implementation is selected for the running cpu on first use,
+//   all levels give the same result, as only the loop is vectorized (no fma, sqrt is exact)
+//   and the dot product for the filterbank rows,
+//   here the vector variants sum in a different order
+template <typename P>
+class SpectrumKernel
+{
+public:
+    using Kernel = void (*)(const P* complex, P* sum, size_t n, P scale);
+    using DotKernel = P (*)(const P* a, const P* b, size_t n);
+
+    static void accumulate(const P* complex, P* sum, size_t n, P scale);
+    static P dot(const P* a, const P* b, size_t n);
+    // the implementation for level, nullptr if the cpu (or the compiler) can't do it
+    static Kernel getKernel(SimdLevel level);
+    static DotKernel getDotKernel(SimdLevel level);
+    // the best level for this cpu
+    static SimdLevel getLevel();
+    static std::string toId(SimdLevel level);
+};
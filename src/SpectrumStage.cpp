@@ -0,0 +1,358 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <cmath>
+#include <algorithm>
+#include <iostream>
+
+#include "SpectrumStage.hpp"
+
+template <typename P>
+void
+SpectrumLevel<P>::process(std::span<P> values, double interval)
+{
+    if (values.empty()) {
+        return;
+    }
+    if (m_gain != LevelGain::Fixed) {
+        follow(values, interval);
+    }
+    else if (!m_decibel) {
+        return;     // nothing to change, the values are used as they are
+    }
+    const double reference = std::max(getReference(), MIN_REFERENCE);
+    const auto target = static_cast<P>(m_target);
+    if (m_decibel) {
+        // 20 log10(v / reference) mapped from [-range, 0] to [0, target]
+        const auto min = static_cast<P>(reference * std::pow(10.0, -m_range / 20.0));
+        const auto offset = static_cast<P>(m_range - 20.0 * std::log10(reference));
+        const auto factor = static_cast<P>(m_target / m_range);
+        for (auto& value : values) {
+            const P db = P{20} * std::log10(std::max(value, min));
+            value = std::clamp((db + offset) * factor, P{}, target);
+        }
+    }
+    else {
+        const auto gain = static_cast<P>(m_target / reference);
+        for (auto& value : values) {
+            value = std::min(value * gain, target);     // until the attack caught up
+        }
+    }
+}
+
+template <typename P>
+void
+SpectrumLevel<P>::follow(std::span<const P> values, double interval)
+{
+    if (m_envelope.size() != values.size()) {
+        m_envelope.resize(values.size());
+        m_order.resize(values.size());
+        m_primed = false;
+    }
+    if (!m_primed) {
+        std::copy(values.begin(), values.end(), m_envelope.begin());
+        m_primed = true;
+    }
+    else {
+        // the exponential moving peak, written without branches so this vectorizes
+        const auto attack = static_cast<P>(1.0 - std::exp(-interval / std::max(m_attack, 1.0e-6)));
+        const auto release = static_cast<P>(1.0 - std::exp(-interval / std::max(m_release, 1.0e-6)));
+        const P* in = values.data();
+        P* envelope = m_envelope.data();
+        for (size_t i = 0; i < values.size(); ++i) {
+            const P diff = in[i] - envelope[i];
+            envelope[i] += (diff > P{} ? attack : release) * diff;
+        }
+    }
+    if (m_gain == LevelGain::Peak) {
+        m_reference = static_cast<double>(*std::max_element(m_envelope.begin(), m_envelope.end()));
+    }
+    else {
+        std::copy(m_envelope.begin(), m_envelope.end(), m_order.begin());
+        auto nth = m_order.begin() + static_cast<std::ptrdiff_t>(m_percentile * static_cast<double>(m_order.size() - 1u));
+        std::nth_element(m_order.begin(), nth, m_order.end());
+        m_reference = static_cast<double>(*nth);
+    }
+#   ifdef DEBUG
+    std::cout << "SpectrumLevel::follow"
+              << " gain " << toId(m_gain)
+              << " reference " << m_reference << std::endl;
+#   endif
+}
+
+template <typename P>
+LevelGain
+SpectrumLevel<P>::getGain()
+{
+    return m_gain;
+}
+
+template <typename P>
+void
+SpectrumLevel<P>::setGain(LevelGain gain)
+{
+    if (gain != m_gain) {
+        m_gain = gain;
+        reset();
+    }
+}
+
+template <typename P>
+bool
+SpectrumLevel<P>::isDecibel()
+{
+    return m_decibel;
+}
+
+template <typename P>
+void
+SpectrumLevel<P>::setDecibel(bool decibel)
+{
+    m_decibel = decibel;
+}
+
+template <typename P>
+void
+SpectrumLevel<P>::setAttack(double attack)
+{
+    m_attack = attack;
+}
+
+template <typename P>
+void
+SpectrumLevel<P>::setRelease(double release)
+{
+    m_release = release;
+}
+
+template <typename P>
+void
+SpectrumLevel<P>::setTarget(double target)
+{
+    m_target = target;
+}
+
+template <typename P>
+void
+SpectrumLevel<P>::setRange(double range)
+{
+    m_range = std::max(range, 1.0);
+}
+
+template <typename P>
+void
+SpectrumLevel<P>::setPercentile(double percentile)
+{
+    m_percentile = std::clamp(percentile, 0.0, 1.0);
+}
+
+template <typename P>
+double
+SpectrumLevel<P>::getReference()
+{
+    return m_gain == LevelGain::Fixed ? m_fixedReference : m_reference;
+}
+
+template <typename P>
+void
+SpectrumLevel<P>::setReference(double reference)
+{
+    m_fixedReference = reference;
+}
+
+template <typename P>
+void
+SpectrumLevel<P>::reset()
+{
+    m_primed = false;
+    m_reference = m_fixedReference;
+}
+
+template <typename P>
+std::string
+SpectrumLevel<P>::toId(LevelGain gain)
+{
+    switch (gain) {
+    case LevelGain::Peak:
+        return GAIN_PEAK;
+    case LevelGain::Percentile:
+        return GAIN_PERCENTILE;
+    default:
+        return GAIN_FIXED;
+    }
+}
+
+template <typename P>
+LevelGain
+SpectrumLevel<P>::fromId(const std::string& id)
+{
+    if (id == GAIN_PEAK) {
+        return LevelGain::Peak;
+    }
+    if (id == GAIN_PERCENTILE) {
+        return LevelGain::Percentile;
+    }
+    return LevelGain::Fixed;
+}
+
+// need template instantiation
+template class SpectrumLevel<double>;
+template class SpectrumLevel<float>;
+
+template <typename P>
+void
+SpectrumSmoothing<P>::resize(size_t bins)
+{
+    if (m_state.size() != bins) {
+        m_state.resize(bins);
+        m_peak.resize(bins);
+        m_age.resize(bins);
+        m_primed = false;
+    }
+}
+
+template <typename P>
+void
+SpectrumSmoothing<P>::process(std::span<P> values, double interval)
+{
+    if (m_mode == SmoothingMode::Off || values.empty()) {
+        return;
+    }
+    resize(values.size());
+    const size_t n = values.size();
+    P* out = values.data();
+    P* state = m_state.data();
+    if (!m_primed) {
+        std::copy(values.begin(), values.end(), m_state.begin());
+        std::copy(values.begin(), values.end(), m_peak.begin());
+        std::fill(m_age.begin(), m_age.end(), P{});
+        m_primed = true;
+        return;
+    }
+    const auto attack = static_cast<P>(1.0 - std::exp(-interval / std::max(m_attack, 1.0e-6)));
+    const auto release = static_cast<P>(1.0 - std::exp(-interval / std::max(m_release, 1.0e-6)));
+    if (m_mode == SmoothingMode::PeakHold) {
+        // the peaks follow the unsmoothed values
+        const auto fall = static_cast<P>(std::exp(-interval / std::max(m_fall, 1.0e-6)));
+        const auto step = static_cast<P>(interval);
+        const auto hold = static_cast<P>(m_hold);
+        P* peak = m_peak.data();
+        P* age = m_age.data();
+        for (size_t i = 0; i < n; ++i) {
+            const bool rise = out[i] >= peak[i];
+            const P aged = age[i] + step;
+            const P fallen = aged > hold ? peak[i] * fall : peak[i];
+            peak[i] = rise ? out[i] : fallen;
+            age[i] = rise ? P{} : aged;
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        const P diff = out[i] - state[i];
+        state[i] += (diff > P{} ? attack : release) * diff;
+        out[i] = state[i];
+    }
+    if (m_mode == SmoothingMode::PeakHold) {
+        const P* peak = m_peak.data();
+        for (size_t i = 0; i < n; ++i) {
+            out[i] = std::max(out[i], peak[i]);
+        }
+    }
+}
+
+template <typename P>
+SmoothingMode
+SpectrumSmoothing<P>::getMode()
+{
+    return m_mode;
+}
+
+template <typename P>
+void
+SpectrumSmoothing<P>::setMode(SmoothingMode mode)
+{
+    if (mode != m_mode) {
+        m_mode = mode;
+        reset();
+    }
+}
+
+template <typename P>
+void
+SpectrumSmoothing<P>::setAttack(double attack)
+{
+    m_attack = attack;
+}
+
+template <typename P>
+void
+SpectrumSmoothing<P>::setRelease(double release)
+{
+    m_release = release;
+}
+
+template <typename P>
+void
+SpectrumSmoothing<P>::setHold(double hold)
+{
+    m_hold = hold;
+}
+
+template <typename P>
+void
+SpectrumSmoothing<P>::setFall(double fall)
+{
+    m_fall = fall;
+}
+
+template <typename P>
+void
+SpectrumSmoothing<P>::reset()
+{
+    m_primed = false;
+}
+
+template <typename P>
+std::string
+SpectrumSmoothing<P>::toId(SmoothingMode mode)
+{
+    switch (mode) {
+    case SmoothingMode::Smooth:
+        return SMOOTHING_SMOOTH;
+    case SmoothingMode::PeakHold:
+        return SMOOTHING_PEAK_HOLD;
+    default:
+        return SMOOTHING_OFF;
+    }
+}
+
+template <typename P>
+SmoothingMode
+SpectrumSmoothing<P>::fromId(const std::string& id)
+{
+    if (id == SMOOTHING_SMOOTH) {
+        return SmoothingMode::Smooth;
+    }
+    if (id == SMOOTHING_PEAK_HOLD) {
+        return SmoothingMode::PeakHold;
+    }
+    return SmoothingMode::Off;
+}
+
+// need template instantiation
+template class SpectrumSmoothing<double>;
+template class SpectrumSmoothing<float>;
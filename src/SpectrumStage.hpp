@@ -0,0 +1,143 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4;  coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <span>
+#include <vector>
+
+// how the reference level (the level that is displayed at the target) is found
+enum class LevelGain
+{
+    Fixed,          // use the reference as set
+    Peak,           // follow the loudest bin
+    Percentile      // follow a percentile of the bins, single loud bins may clip
+};
+
+// a streaming normalization of spectrum (or tile) values, applied in place,
+//   with an automatic gain that follows the per bin envelopes (attack/release)
+//   and optionally a logarithmic (dB) display of the range below the reference.
+//   The state is one envelope value per bin, allocated when the bin count changes
+template <typename P>
+class SpectrumLevel
+{
+public:
+    SpectrumLevel() = default;
+    explicit SpectrumLevel(const SpectrumLevel& orig) = delete;
+    virtual ~SpectrumLevel() = default;
+
+    // @param interval the time since the previous frame in seconds
+    void process(std::span<P> values, double interval);
+    LevelGain getGain();
+    void setGain(LevelGain gain);
+    bool isDecibel();
+    void setDecibel(bool decibel);
+    // the time constants in seconds, a short attack avoids clipping
+    void setAttack(double attack);
+    void setRelease(double release);
+    // the output for the reference level (e.g. the maximum the display can show)
+    void setTarget(double target);
+    // the range in dB below the reference that is displayed
+    void setRange(double range);
+    void setPercentile(double percentile);
+    // the level in use that is displayed at the target
+    double getReference();
+    // for the fixed gain, in the units of the processed values
+    //   (e.g. the display units if these are scaled already)
+    void setReference(double reference);
+    void reset();
+    static std::string toId(LevelGain gain);
+    static LevelGain fromId(const std::string& id);
+
+    static constexpr auto GAIN_FIXED{"fixed"};
+    static constexpr auto GAIN_PEAK{"peak"};
+    static constexpr auto GAIN_PERCENTILE{"percentile"};
+    // don't raise silence to the target
+    static constexpr double MIN_REFERENCE{1.0e-4};
+
+protected:
+    void follow(std::span<const P> values, double interval);
+
+private:
+    std::vector<P> m_envelope;
+    std::vector<P> m_order;     // for the percentile
+    bool m_primed{false};
+    LevelGain m_gain{LevelGain::Fixed};
+    bool m_decibel{false};
+    double m_attack{0.05};
+    double m_release{3.0};
+    double m_target{1.0};
+    double m_range{60.0};
+    double m_percentile{0.95};
+    double m_reference{1.0};
+    double m_fixedReference{1.0};
+};
+
+enum class SmoothingMode
+{
+    Off,
+    Smooth,         // exponential attack and release per bin
+    PeakHold        // smooth and keep the peaks for the hold time, then let them fall
+};
+
+// a temporal model for the spectrum frames, applied in place before the tile mapping,
+//   so short (low latency) ffts still give a steady display.
+//   The loops are kept without branches to allow the compiler to vectorize
+template <typename P>
+class SpectrumSmoothing
+{
+public:
+    SpectrumSmoothing() = default;
+    explicit SpectrumSmoothing(const SpectrumSmoothing& orig) = delete;
+    virtual ~SpectrumSmoothing() = default;
+
+    // preallocate the state, process does this as well if the bin count changed
+    void resize(size_t bins);
+    // @param interval the time since the previous frame in seconds
+    void process(std::span<P> values, double interval);
+    SmoothingMode getMode();
+    void setMode(SmoothingMode mode);
+    // the time constants in seconds
+    void setAttack(double attack);
+    void setRelease(double release);
+    // how long a peak stays in seconds
+    void setHold(double hold);
+    // the time constant in seconds the peaks fall with after the hold
+    void setFall(double fall);
+    void reset();
+    static std::string toId(SmoothingMode mode);
+    static SmoothingMode fromId(const std::string& id);
+
+    static constexpr auto SMOOTHING_OFF{"off"};
+    static constexpr auto SMOOTHING_SMOOTH{"smooth"};
+    static constexpr auto SMOOTHING_PEAK_HOLD{"peakHold"};
+
+private:
+    std::vector<P> m_state;
+    std::vector<P> m_peak;
+    std::vector<P> m_age;       // of the peak in seconds
+    bool m_primed{false};
+    SmoothingMode m_mode{SmoothingMode::Off};
+    double m_attack{0.02};
+    double m_release{0.25};
+    double m_hold{0.5};
+    double m_fall{0.3};
+};
@@ -73,12 +73,12 @@ CooleyTukey<windowSize>::execute(const ChunkedArray<int16_t>& in)
     std::vector<std::complex<float>> A;
     A.resize(windowSize);
     std::ranges::fill(A, std::complex<float>(0.0f, 0.0f));
+    std::vector<float> samples;
+    samples.resize(windowSize);
     for (uint32_t p = 0; p < in.size(); p += hopSize) {
+        in.copy_window(p, windowSize, samples.data(), static_cast<float>(in.getInputScale()));
         for (uint32_t k = 0; k < windowSize; ++k) {
-            A[m_reversed[k]] = std::complex<float>((p + k < in.size())
-                                                    ? (in[p + k] * static_cast<float>(in.getInputScale()) * m_normHamming[k])
-                                                    : 0.0f
-                                                  , 0.0f);
+            A[m_reversed[k]] = std::complex<float>(samples[k] * m_normHamming[k], 0.0f);
         }
         for (uint32_t s = 1, m = 2; s <= LOGN; s++, m *= 2) {
             auto omega_m = std::exp(std::complex<float>(0.0f, -TWO_PI / static_cast<float>(m)));
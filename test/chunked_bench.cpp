@@ -0,0 +1,172 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <string>
+
+#include "ChunkedArray.hpp"
+
+// compare the access patterns of the ChunkedArray storage modes
+//   the output is csv: test,storage,chunk,param,ops,seconds,nsPerOp,check
+//   (check is only there to keep the compiler from removing the work)
+
+static constexpr size_t SAMPLES{44100u * 10u};     // 10s at cd rate
+static constexpr size_t WINDOW{512u};
+
+struct Variant
+{
+    const char* name;
+    ChunkedStorage storage;
+    size_t coalesce;
+};
+
+static void
+report(const std::string& test, const Variant& variant, size_t chunk, size_t param
+    , size_t ops, std::chrono::steady_clock::time_point start, int64_t check)
+{
+    auto finish = std::chrono::steady_clock::now();
+    double elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(finish - start).count();
+    std::cout << test
+              << "," << variant.name
+              << "," << chunk
+              << "," << param
+              << "," << ops
+              << "," << elapsed_seconds
+              << "," << (elapsed_seconds * 1.0e9 / static_cast<double>(ops))
+              << "," << check << std::endl;
+}
+
+// the chunks as they would be delivered by pulse
+static std::vector<std::shared_ptr<std::vector<int16_t>>>
+createChunks(size_t chunk)
+{
+    std::vector<std::shared_ptr<std::vector<int16_t>>> chunks;
+    for (size_t i = 0; i < SAMPLES; i += chunk) {
+        auto data = std::make_shared<std::vector<int16_t>>();
+        data->resize(std::min(chunk, SAMPLES - i));
+        for (size_t j = 0; j < data->size(); ++j) {
+            data->operator[](j) = static_cast<int16_t>((i + j) % 2000u);
+        }
+        chunks.push_back(data);
+    }
+    return chunks;
+}
+
+static ChunkedArray<int16_t>
+benchAdd(const std::vector<std::shared_ptr<std::vector<int16_t>>>& chunks, const Variant& variant, size_t chunk)
+{
+    auto start = std::chrono::steady_clock::now();
+    ChunkedArray<int16_t> data{1, variant.storage};
+    data.setCoalesce(variant.coalesce);
+    for (auto& c : chunks) {
+        data.add(c);
+    }
+    // use check to show the resulting chunks
+    report("add", variant, chunk, 0, data.size(), start, static_cast<int64_t>(data.getStatistics().chunks));
+    return data;
+}
+
+static void
+benchSequential(const ChunkedArray<int16_t>& data, const Variant& variant, size_t chunk)
+{
+    auto start = std::chrono::steady_clock::now();
+    int64_t sum{};
+    for (size_t i = 0; i < data.size(); ++i) {
+        sum += data[i];
+    }
+    report("sequential", variant, chunk, 0, data.size(), start, sum);
+
+    start = std::chrono::steady_clock::now();
+    sum = 0;
+    data.for_each_segment(0, data.size(), [&] (std::span<const int16_t> segment) {
+        for (auto v : segment) {
+            sum += v;
+        }
+    });
+    report("segments", variant, chunk, 0, data.size(), start, sum);
+}
+
+static void
+benchRandom(const ChunkedArray<int16_t>& data, const Variant& variant, size_t chunk)
+{
+    const size_t ops{data.size()};
+    uint64_t rnd{12345u};
+    auto start = std::chrono::steady_clock::now();
+    int64_t sum{};
+    for (size_t i = 0; i < ops; ++i) {
+        rnd = rnd * 6364136223846793005ull + 1442695040888963407ull;    // lcg keeps the sequence reproducible
+        sum += data[(rnd >> 33) % data.size()];
+    }
+    report("random", variant, chunk, 0, ops, start, sum);
+}
+
+static void
+benchWindows(const ChunkedArray<int16_t>& data, const Variant& variant, size_t chunk)
+{
+    std::vector<double> window;
+    window.resize(WINDOW);
+    for (size_t hop : {WINDOW / 4, WINDOW / 2, WINDOW}) {
+        auto start = std::chrono::steady_clock::now();
+        double sum{};
+        size_t ops{};
+        for (size_t pos = 0; pos + WINDOW <= data.size(); pos += hop) {
+            for (size_t i = 0; i < WINDOW; ++i) {
+                window[i] = static_cast<double>(data[pos + i]);
+            }
+            sum += window[WINDOW / 2];
+            ops += WINDOW;
+        }
+        report("windowIndex", variant, chunk, hop, ops, start, static_cast<int64_t>(sum));
+
+        start = std::chrono::steady_clock::now();
+        sum = 0.0;
+        ops = 0;
+        for (size_t pos = 0; pos + WINDOW <= data.size(); pos += hop) {
+            data.copy_window(pos, WINDOW, window.data(), 1.0);
+            sum += window[WINDOW / 2];
+            ops += WINDOW;
+        }
+        report("windowCopy", variant, chunk, hop, ops, start, static_cast<int64_t>(sum));
+    }
+}
+
+static constexpr Variant VARIANTS[] {
+      {"chunked", ChunkedStorage::Chunked, 0u}
+    , {"coalesced", ChunkedStorage::Chunked, 4096u}
+    , {"ring", ChunkedStorage::Ring, 0u}
+};
+
+int main(int argc, char** argv)
+{
+    std::cout << "test,storage,chunk,param,ops,seconds,nsPerOp,check" << std::endl;
+    // typical pulse fragment sizes (10ms, 20ms, 40ms at 44.1kHz) and some powers of two
+    for (size_t chunk : {256u, 441u, 882u, 1024u, 1764u, 4096u}) {
+        auto chunks = createChunks(chunk);
+        for (auto& variant : VARIANTS) {
+            auto data = benchAdd(chunks, variant, chunk);
+            benchSequential(data, variant, chunk);
+            benchRandom(data, variant, chunk);
+            benchWindows(data, variant, chunk);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <chrono>
+#include <memory>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Fft.hpp"
+#include "SpectrumKernel.hpp"
+
+// compare the batched transform with one window at a time
+//   the output is csv: fft,batched,seconds,windows,total,usPerWindow,check
+//   (check is only there to keep the compiler from removing the work)
+//   followed by the split on threads for the longer inputs: fft,threads,seconds,windows,total,usPerWindow,check
+//   and the snapshot scaling with the fftw threads: snapshot,threads,size,total,usPerTransform,check
+//   and the magnitude kernels of Spectrum::add: kernel,precision,bins,total,nsPerAdd,check
+
+static constexpr size_t RATE{44100u};
+static constexpr size_t REPEAT{5u};
+
+template<uint32_t windowSize>
+static void
+bench(Fft<windowSize>* fft, const std::string& name, const ChunkedArray<int16_t>& data, double seconds)
+{
+    for (bool batched : {false, true}) {
+        fft->setBatched(batched);
+        fft->execute(data);     // leave the setup out
+        double check{};
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < REPEAT; ++i) {
+            check += fft->execute(data)->getMax();
+        }
+        auto finish = std::chrono::steady_clock::now();
+        double elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(finish - start).count();
+        auto windows = (data.size() - windowSize) / fft->getHopSize() + 1u;
+        std::cout << name
+                  << "," << batched
+                  << "," << seconds
+                  << "," << windows
+                  << "," << elapsed_seconds
+                  << "," << (elapsed_seconds * 1.0e6 / static_cast<double>(windows * REPEAT))
+                  << "," << check << std::endl;
+    }
+}
+
+template<uint32_t windowSize>
+static void
+benchThreads(Fft<windowSize>* fft, const std::string& name, const ChunkedArray<int16_t>& data, double seconds)
+{
+    fft->setBatched(true);
+    for (uint32_t threads : {1u, 2u, 4u, 0u}) {
+        fft->setThreads(threads);
+        fft->execute(data);
+        double check{};
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < REPEAT; ++i) {
+            check += fft->execute(data)->getMax();
+        }
+        auto finish = std::chrono::steady_clock::now();
+        double elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(finish - start).count();
+        auto windows = (data.size() - windowSize) / fft->getHopSize() + 1u;
+        std::cout << name
+                  << "," << (threads > 0u ? threads : std::thread::hardware_concurrency())
+                  << "," << seconds
+                  << "," << windows
+                  << "," << elapsed_seconds
+                  << "," << (elapsed_seconds * 1.0e6 / static_cast<double>(windows * REPEAT))
+                  << "," << check << std::endl;
+    }
+    fft->setThreads(1u);
+}
+
+static void
+benchSnapshot(const ChunkedArray<int16_t>& data, uint32_t size)
+{
+    std::vector<uint32_t> threads{1u, 2u, 4u};
+    if (std::thread::hardware_concurrency() > 4u) {
+        threads.push_back(std::thread::hardware_concurrency());
+    }
+    for (uint32_t thread : threads) {
+        FftSnapshot<double> snapshot{size, thread};   // leave the planning out
+        snapshot.execute(data);
+        double check{};
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < REPEAT; ++i) {
+            check += snapshot.execute(data)[size / 4u];
+        }
+        auto finish = std::chrono::steady_clock::now();
+        double elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(finish - start).count();
+        std::cout << "snapshot"
+                  << "," << thread
+                  << "," << size
+                  << "," << elapsed_seconds
+                  << "," << (elapsed_seconds * 1.0e6 / static_cast<double>(REPEAT))
+                  << "," << check << std::endl;
+    }
+}
+
+template <typename P>
+static void
+benchConstantQ(const std::string& precision, const ChunkedArray<int16_t>& data, uint32_t binsPerOctave)
+{
+    FftConstantQ<int16_t, P> constantQ{1u, static_cast<double>(RATE), 55.0, 7040.0, binsPerOctave};
+    double frameTime{};
+    double check{};
+    for (size_t i = 0; i < REPEAT; ++i) {
+        constantQ.push(data);
+        frameTime += constantQ.getFrameTime();
+        check += constantQ.getValues()[constantQ.getBinCount() / 2u];
+    }
+    std::cout << "constantQ"
+              << "," << precision
+              << "," << binsPerOctave
+              << "," << constantQ.getBinCount()
+              << "," << constantQ.getFftSize()
+              << "," << constantQ.getKernelSize()
+              << "," << (frameTime / static_cast<double>(REPEAT))
+              << "," << check << std::endl;
+}
+
+template <typename P>
+static void
+benchKernel(const std::string& precision, size_t bins)
+{
+    constexpr size_t ADDS{200000u};
+    std::vector<P> values(2u * bins);
+    for (size_t i = 0; i < values.size(); ++i) {
+        values[i] = static_cast<P>(i % 97u);
+    }
+    for (auto level : {SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2}) {
+        auto kernel = SpectrumKernel<P>::getKernel(level);
+        if (!kernel) {
+            continue;
+        }
+        std::vector<P> sum(bins, P{});
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < ADDS; ++i) {
+            kernel(values.data(), sum.data(), bins, P{1} / static_cast<P>(ADDS));
+        }
+        auto finish = std::chrono::steady_clock::now();
+        double elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(finish - start).count();
+        std::cout << SpectrumKernel<P>::toId(level)
+                  << "," << precision
+                  << "," << bins
+                  << "," << elapsed_seconds
+                  << "," << (elapsed_seconds * 1.0e9 / static_cast<double>(ADDS))
+                  << "," << sum[bins / 2u] << std::endl;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::cout << "kernel,precision,bins,total,nsPerAdd,check" << std::endl;
+    for (size_t bins : {257u, 1025u}) {
+        benchKernel<double>("double", bins);
+        benchKernel<float>("float", bins);
+    }
+    std::cout << "fft,batched,seconds,windows,total,usPerWindow,check" << std::endl;
+    SinusSignal sinus;
+    Fft512 fft512;
+    Fft512n256 fft512n256;
+    Fft2k fft2k;
+    Fft2k1k fft2k1k;
+    for (double seconds : {0.25, 1.0, 5.0, 15.0, 60.0}) {
+        auto data = sinus.generate(static_cast<size_t>(seconds * static_cast<double>(RATE)), static_cast<float>(RATE) / 1000.0f);
+        bench<512u>(&fft512, "Fft512", data, seconds);
+        bench<512u>(&fft512n256, "Fft512n256", data, seconds);
+        bench<2048u>(&fft2k, "Fft2k", data, seconds);
+        bench<2048u>(&fft2k1k, "Fft2k1k", data, seconds);
+    }
+    std::cout << "fft,threads,seconds,windows,total,usPerWindow,check" << std::endl;
+    for (double seconds : {60.0, 300.0}) {
+        auto data = sinus.generate(static_cast<size_t>(seconds * static_cast<double>(RATE)), static_cast<float>(RATE) / 1000.0f);
+        benchThreads<512u>(&fft512n256, "Fft512n256", data, seconds);
+        benchThreads<2048u>(&fft2k1k, "Fft2k1k", data, seconds);
+    }
+    std::cout << "snapshot,threads,size,total,usPerTransform,check" << std::endl;
+    auto data = sinus.generate(1u << 20u, static_cast<float>(RATE) / 1000.0f);
+    for (uint32_t size : {1u << 16u, 1u << 18u, 1u << 20u}) {
+        benchSnapshot(data, size);
+    }
+    std::cout << "constantQ,precision,binsPerOctave,bins,fftSize,kernelSize,usPerFrame,check" << std::endl;
+    for (uint32_t binsPerOctave : {12u, 24u}) {
+        benchConstantQ<double>("double", data, binsPerOctave);
+        benchConstantQ<float>("float", data, binsPerOctave);
+    }
+    return 0;
+}
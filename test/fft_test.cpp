@@ -27,10 +27,13 @@
 #include <fftw3.h>
 #include <numeric>  // accumulate
 #include <algorithm>
+#include <filesystem>
 #include <psc_format.hpp>
 
 #include "CooleyTukey.hpp"
 #include "Fft.hpp"
+#include "SpectrumKernel.hpp"
+#include "SpectrumStage.hpp"
 
 #define REAL 0
 #define IMAG 1
@@ -76,6 +79,948 @@ check_fft(Fft<windowSize>* fft, const std::string& name, ChunkedArray<int16_t>&
 }
 
 
+// the complex to complex transform as it was used before the real to complex,
+//   keep it as reference for values and time
+template<uint32_t windowSize>
+static std::vector<double>
+reference_c2c(const ChunkedArray<int16_t>& in, uint32_t hopSize, double& elapsed_seconds)
+{
+    HammingWindow<windowSize> window;
+    auto input = fftw_alloc_complex(windowSize);
+    auto result = fftw_alloc_complex(windowSize);
+    auto plan = fftw_plan_dft_1d(windowSize, input, result, FFTW_FORWARD, FFTW_ESTIMATE);
+    std::vector<double> sum(windowSize / 2 + 1, 0.0);
+    auto start = std::chrono::steady_clock::now();
+    size_t pos{}, chunks{};
+    bool stop{false};
+    while (pos < in.size() - windowSize - 1 && !stop) {
+        for (size_t i = 0; i < windowSize; ++i) {
+            if (pos + i < in.size()) {
+                input[i][REAL] = in[pos + i] * in.getInputScale() * window.windowing(i);
+            }
+            else {
+                input[i][REAL] = 0.0;
+                stop = true;
+            }
+            input[i][IMAG] = 0.0;
+        }
+        fftw_execute(plan);
+        for (size_t i = 0; i < sum.size(); ++i) {
+            auto abs = std::sqrt(result[i][REAL] * result[i][REAL] + result[i][IMAG] * result[i][IMAG]);
+            auto scale = (i < sum.size() - 1) ? 2.0 : 1.0;
+            sum[i] += abs * scale / static_cast<double>(windowSize);
+        }
+        pos += hopSize;
+        ++chunks;
+    }
+    for (auto& s : sum) {
+        s /= static_cast<double>(chunks);
+    }
+    auto finish = std::chrono::steady_clock::now();
+    elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(finish - start).count();
+    fftw_destroy_plan(plan);
+    fftw_free(input);
+    fftw_free(result);
+    return sum;
+}
+
+// compare the real to complex result and time with the complex reference
+template<uint32_t windowSize>
+static bool
+check_r2c(Fft<windowSize>* fft, const std::string& name, const ChunkedArray<int16_t>& data)
+{
+    double c2c_seconds{};
+    auto ref = reference_c2c<windowSize>(data, fft->getHopSize(), c2c_seconds);
+    auto start = std::chrono::steady_clock::now();
+    auto spec = fft->execute(data);
+    auto finish = std::chrono::steady_clock::now();
+    double r2c_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(finish - start).count();
+    auto& sum = spec->getSum();
+    auto max = std::ranges::max(ref);
+    double maxErr{};
+    for (size_t i = 0; i < sum.size(); ++i) {
+        maxErr = std::max(maxErr, std::abs(sum[i] - ref[i]));
+    }
+    std::cout << name
+              << " c2c " << c2c_seconds
+              << " r2c " << r2c_seconds
+              << " speedup " << c2c_seconds / r2c_seconds
+              << " max err " << maxErr / max << std::endl;
+    return sum.size() == ref.size()
+        && maxErr / max < 1.0e-9;
+}
+
+// the batched transform has to give the same values as one window at a time,
+//   include lengths that leave a incomplete batch
+template<uint32_t windowSize>
+static bool
+check_batched(Fft<windowSize>* fft, const std::string& name)
+{
+    SinusSignal sinus;
+    for (size_t samples : {1000u, 11025u, 44100u * 3u + 17u}) {
+        auto data = sinus.generate(samples, 44100.0f / 1000.0f);
+        fft->setBatched(false);
+        auto single = fft->execute(data);
+        fft->setBatched(true);
+        auto batched = fft->execute(data);
+        auto max = single->getMax();
+        for (size_t i = 0; i < single->getSum().size(); ++i) {
+            if (std::abs(single->getSum()[i] - batched->getSum()[i]) / max > 1.0e-12) {
+                std::cout << name << " batched differs samples " << samples
+                          << " at " << i
+                          << " single " << single->getSum()[i]
+                          << " batched " << batched->getSum()[i] << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// the single precision has to stay close to the double path
+template<uint32_t windowSize>
+static bool
+check_precision(Fft<windowSize>* fft, Fft<windowSize, float>* fftf, const std::string& name, const ChunkedArray<int16_t>& data)
+{
+    auto start = std::chrono::steady_clock::now();
+    auto spec = fft->execute(data);
+    auto finish = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration_cast<std::chrono::duration<double>>(finish - start).count();
+    start = std::chrono::steady_clock::now();
+    auto specf = fftf->execute(data);
+    finish = std::chrono::steady_clock::now();
+    double secondsf = std::chrono::duration_cast<std::chrono::duration<double>>(finish - start).count();
+    auto& sum = spec->getSum();
+    auto& sumf = specf->getSum();
+    auto max = spec->getMax();
+    double maxErr{};
+    for (size_t i = 0; i < sum.size(); ++i) {
+        maxErr = std::max(maxErr, std::abs(sum[i] - static_cast<double>(sumf[i])));
+    }
+    std::cout << name
+              << " double " << seconds
+              << " float " << secondsf
+              << " max err " << maxErr / max << std::endl;
+    return maxErr / max < 1.0e-5;
+}
+
+// the runtime sized engine has to match the fixed size and use the cached plans
+static bool
+check_engine(Fft<512u>* fft, const ChunkedArray<int16_t>& data)
+{
+    FftEngine<double> engine{512u};
+    auto spec = fft->execute(data);
+    auto specEngine = engine.execute(data);
+    auto max = spec->getMax();
+    for (size_t i = 0; i < spec->getSum().size(); ++i) {
+        if (std::abs(spec->getSum()[i] - specEngine->getSum()[i]) / max > 1.0e-9) {
+            std::cout << "engine differs at " << i
+                      << " fixed " << spec->getSum()[i]
+                      << " engine " << specEngine->getSum()[i] << std::endl;
+            return false;
+        }
+    }
+    if (FftPlanner::getSetup<double>(512u) != FftPlanner::getSetup<double>(512u)) {
+        std::cout << "engine setup not cached" << std::endl;
+        return false;
+    }
+    // a size without fixed variant, 1kHz at 44.1kHz is expected at bin 1024 / 44.1
+    FftEngine<double> engine1k{1024u, 512u};
+    auto spec1k = engine1k.execute(data);
+    auto& sum1k = spec1k->getSum();
+    auto peak = std::distance(sum1k.begin(), std::ranges::max_element(sum1k));
+    std::cout << "engine 1k"
+              << " bins " << engine1k.getBins()
+              << " peak " << peak << std::endl;
+    return sum1k.size() == 513u
+        && peak == 23;
+}
+
+// long inputs split on threads shall give the same spectrum (up to rounding)
+static bool
+check_parallel()
+{
+    SinusSignal sinus;
+    auto data = sinus.generate(60u * 44100u, 44100.0f / 1000.0f);
+    FftEngine<double> serial{512u, 256u};
+    auto expected = serial.execute(data);
+    FftEngine<double> parallel{512u, 256u};
+    parallel.setThreads(4u);
+    auto spec = parallel.execute(data);
+    auto again = parallel.execute(data);
+    auto max = expected->getMax();
+    for (size_t i = 0; i < expected->getSum().size(); ++i) {
+        if (std::abs(spec->getSum()[i] - expected->getSum()[i]) / max > 1.0e-12) {
+            std::cout << "parallel differs at " << i
+                      << " parallel " << spec->getSum()[i]
+                      << " serial " << expected->getSum()[i] << std::endl;
+            return false;
+        }
+        if (spec->getSum()[i] != again->getSum()[i]) {
+            std::cout << "parallel not repeatable at " << i << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// the snapshot shall find the tone with the fine resolution, regardless of the threads used
+static bool
+check_snapshot()
+{
+    constexpr uint32_t size{65536u};
+    SinusSignal sinus;
+    auto data = sinus.generate(size + 1000u, 44100.0f / 1000.0f);
+    FftSnapshot<double> single{size, 1u};
+    FftSnapshot<double> threaded{size, 4u};
+    auto& magnitudes = single.execute(data);
+    auto& threadedMagnitudes = threaded.execute(data);
+    auto peak = std::distance(magnitudes.begin(), std::max_element(magnitudes.begin(), magnitudes.end()));
+    double expectedPeak = 1000.0 / single.getBinWidth(44100.0);
+    std::cout << "snapshot peak " << peak
+              << " expected " << expectedPeak << std::endl;
+    if (std::abs(static_cast<double>(peak) - expectedPeak) > 1.0) {
+        return false;
+    }
+    for (size_t i = 0; i < magnitudes.size(); ++i) {
+        if (std::abs(magnitudes[i] - threadedMagnitudes[i]) / magnitudes[peak] > 1.0e-9) {
+            std::cout << "snapshot threads differ at " << i << std::endl;
+            return false;
+        }
+    }
+    auto display = single.decimate(512u);
+    if (display.size() != 512u
+     || *std::max_element(display.begin(), display.end()) != magnitudes[peak]) {
+        std::cout << "snapshot decimate lost the peak" << std::endl;
+        return false;
+    }
+    auto zoomed = single.decimate(64u, static_cast<uint32_t>(peak) - 16u, static_cast<uint32_t>(peak) + 16u);
+    if (zoomed[32] != magnitudes[peak]) {
+        std::cout << "snapshot zoom " << zoomed[32] << " expected " << magnitudes[peak] << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// all kernels available on this cpu shall give the same as the scalar loop,
+//   and be close to the previous per bin scaling
+template <typename P>
+static bool
+check_kernel(P tolerance)
+{
+    for (size_t bins : {257u, 1025u, 7u}) {
+        std::vector<P> values(2u * bins);
+        for (size_t i = 0; i < values.size(); ++i) {
+            values[i] = static_cast<P>(std::sin(static_cast<double>(i) * 0.37) * 1000.0);
+        }
+        const double addScale{0.7};
+        const double windowSize = static_cast<double>(2u * (bins - 1u));
+        std::vector<P> reference(bins, P{1});
+        for (size_t i = 0; i < bins; ++i) {
+            auto abs = std::sqrt(values[2u * i] * values[2u * i] + values[2u * i + 1u] * values[2u * i + 1u]);
+            auto scale = static_cast<P>(addScale) * (i < bins - 1u ? P{2} : P{1});
+            reference[i] += abs * scale / static_cast<P>(windowSize);
+        }
+        std::vector<P> scalar;
+        for (auto level : {SimdLevel::Scalar, SimdLevel::Sse2, SimdLevel::Avx2}) {
+            auto kernel = SpectrumKernel<P>::getKernel(level);
+            if (!kernel) {
+                std::cout << "kernel " << SpectrumKernel<P>::toId(level) << " not supported" << std::endl;
+                continue;
+            }
+            std::vector<P> sum(bins, P{1});
+            kernel(values.data(), sum.data(), bins - 1u, static_cast<P>(2.0 * addScale / windowSize));
+            kernel(values.data() + 2u * (bins - 1u), sum.data() + bins - 1u, 1u, static_cast<P>(addScale / windowSize));
+            if (level == SimdLevel::Scalar) {
+                scalar = sum;
+            }
+            for (size_t i = 0; i < bins; ++i) {
+                if (sum[i] != scalar[i]
+                 || std::abs(sum[i] - reference[i]) > tolerance * reference[i]) {
+                    std::cout << "kernel " << SpectrumKernel<P>::toId(level)
+                              << " bins " << bins
+                              << " differs at " << i
+                              << " sum " << sum[i]
+                              << " scalar " << scalar[i]
+                              << " reference " << reference[i] << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// the compile time tables shall match the runtime ones,
+//   and with the correction a sine shall give the same level for each window
+template <typename Policy>
+static bool
+check_window(FftWindowType type)
+{
+    auto& table = PolicyWindow<Policy, 512u>::getValues();
+    auto values = FftWindows::create<double>(type, 512u);
+    double sum{}, sum2{};
+    for (size_t i = 0; i < table.size(); ++i) {
+        if (std::abs(table[i] - values[i]) > 1.0e-12) {
+            std::cout << "window " << FftWindows::toId(type) << " differs at " << i << std::endl;
+            return false;
+        }
+        sum += values[i];
+        sum2 += values[i] * values[i];
+    }
+    auto amplitude = sum / static_cast<double>(values.size());
+    auto energy = std::sqrt(sum2 / static_cast<double>(values.size()));
+    std::cout << "window " << FftWindows::toId(type)
+              << " amplitude " << amplitude << " " << Policy::AMPLITUDE_CORRECTION
+              << " energy " << energy << " " << Policy::ENERGY_CORRECTION << std::endl;
+    if (std::abs(amplitude - Policy::AMPLITUDE_CORRECTION) > 0.01 * amplitude
+     || std::abs(energy - Policy::ENERGY_CORRECTION) > 0.01 * energy) {
+        return false;
+    }
+    // a sine centered on bin 32
+    SinusSignal sinus;
+    auto data = sinus.generate(8192u, 1024.0f / 32.0f);
+    FftEngine<double> hamming{1024u};
+    FftEngine<double> engine{1024u, 0u, type};
+    auto expected = hamming.execute(data)->getSum()[32];
+    auto level = engine.execute(data)->getSum()[32];
+    if (std::abs(level - expected) > 0.01 * expected) {
+        std::cout << "window " << FftWindows::toId(type)
+                  << " level " << level
+                  << " hamming " << expected << std::endl;
+        return false;
+    }
+    return FftWindows::fromId(FftWindows::toId(type)) == type;
+}
+
+// the table driven adjust shall give the same as the previous per bin loop
+static std::vector<float>
+reference_adjust(std::vector<double>& sum, size_t cnt, double usageFactor, double factor, bool keepSum, bool log)
+{
+    std::vector<float> fout(cnt, 0.0f);
+    const size_t sumSize = static_cast<size_t>(static_cast<double>(sum.size()) * usageFactor);
+    double factorLin = static_cast<double>(cnt) / static_cast<double>(sumSize);
+    double factorLog = (10.0 - 1.0) / static_cast<double>(sumSize);
+    std::vector<size_t> binCnt(cnt, 0u);
+    for (size_t i = 0; i < sumSize; ++i) {
+        if (log) {
+            auto n = std::min(static_cast<size_t>(std::log10(1.0 + static_cast<double>(i) * factorLog) * static_cast<double>(cnt)), static_cast<size_t>(cnt-1));
+            fout[n] = std::max(fout[n], static_cast<float>(sum[i] * factor));
+            ++binCnt[n];
+        }
+        else {
+            auto n = static_cast<size_t>(static_cast<double>(i) * factorLin);
+            fout[n] += static_cast<float>(sum[i] * factor);
+            ++binCnt[n];
+        }
+    }
+    for (size_t n = 0; n < fout.size(); ++n) {
+        if (!keepSum && binCnt[n] > 0u) {
+            fout[n] /= static_cast<float>(binCnt[n]);
+        }
+    }
+    return fout;
+}
+
+static bool
+check_mapping(Fft<512u>* fft512, Fft<2048u>* fft2k, const ChunkedArray<int16_t>& data)
+{
+    std::vector<std::shared_ptr<SpectrumBase<double>>> specs{fft512->execute(data), fft2k->execute(data)};
+    std::vector<float> fout;
+    for (auto& spec : specs) {
+        for (size_t cnt : {64u, 128u, 200u}) {
+            for (double usage : {0.5, 1.0}) {
+                for (bool keepSum : {false, true}) {
+                    for (bool log : {false, true}) {
+                        auto expected = reference_adjust(spec->getSum(), cnt, usage, 2.0, keepSum, log);
+                        if (log) {
+                            spec->adjustLog(fout, cnt, usage, 2.0, keepSum);
+                        }
+                        else {
+                            spec->adjustLin(fout, cnt, usage, 2.0, keepSum);
+                        }
+                        if (fout != expected) {
+                            std::cout << "mapping differs"
+                                      << " bins " << spec->getSum().size()
+                                      << " cnt " << cnt
+                                      << " usage " << usage
+                                      << " keepSum " << keepSum
+                                      << " log " << log << std::endl;
+                            return false;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    // the second use comes from the cache
+    return SpectrumMapping::get(257u, 64u, 0.5, SpectrumScale::Linear) == SpectrumMapping::get(257u, 64u, 0.5, SpectrumScale::Linear);
+}
+
+// the execute into a reused spectrum shall give the same as the allocating one
+static bool
+check_into(Fft512* fft, const ChunkedArray<int16_t>& data)
+{
+    auto expected = fft->execute(data);
+    Spectrum<512u> spectrum;
+    for (size_t i = 0; i < 2u; ++i) {   // the second use shall not add up
+        fft->execute(data, spectrum);
+        if (spectrum.getSum() != expected->getSum()) {
+            std::cout << "into differs for use " << i << std::endl;
+            return false;
+        }
+    }
+    SpectrumBase<double> wrongSize{1024u};
+    try {
+        fft->execute(data, wrongSize);
+        std::cout << "into accepted a wrong size" << std::endl;
+        return false;
+    }
+    catch (const std::runtime_error& exc) {
+    }
+    FftStream<int16_t, double> stream{1u, 512u};
+    auto pushed = stream.push(data);
+    FftStream<int16_t, double> streamInto{1u, 512u};
+    SpectrumBase<double> into{512u};
+    if (!streamInto.push(data, into)
+     || into.getSum() != pushed->getSum()) {
+        std::cout << "stream into differs" << std::endl;
+        return false;
+    }
+    // a push that completes no window keeps the values
+    auto values = std::vector<double>(into.getValues().begin(), into.getValues().end());
+    if (streamInto.push(data.slice(0, 10u), into)
+     || into.getSum() != values) {
+        std::cout << "stream into changed without window" << std::endl;
+        return false;
+    }
+    // a rejected push shall leave the stream as it was
+    const auto pending = streamInto.getPending();
+    try {
+        streamInto.push(data, wrongSize);
+        std::cout << "stream into accepted a wrong size" << std::endl;
+        return false;
+    }
+    catch (const std::runtime_error& exc) {
+    }
+    if (streamInto.getPending() != pending) {
+        std::cout << "stream into changed by a rejected push" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// the perceptual filterbank shall find the tone in the filter around it,
+//   and the vectorized apply shall match the plain sum
+static bool
+check_filterbank(Fft<2048u>* fft)
+{
+    for (auto scale : {SpectrumScale::Mel, SpectrumScale::Bark}) {
+        if (std::abs(SpectrumMapping::fromScale(SpectrumMapping::toScale(1000.0, scale), scale) - 1000.0) > 1.0e-6) {
+            std::cout << "filterbank scale not reversible" << std::endl;
+            return false;
+        }
+    }
+    SinusSignal sinus;
+    auto data = sinus.generate(44100u, 44100.0f / 1000.0f);    // ~ 1kHz
+    auto spec = fft->execute(data);
+    for (auto scale : {SpectrumScale::Mel, SpectrumScale::Bark}) {
+        constexpr size_t cnt{64u};
+        auto filterbank = SpectrumMapping::getFilterbank<double>(spec->getSum().size(), cnt, 44100.0, 0.5, scale);
+        std::vector<float> fout;
+        spec->adjustFilterbank(fout, cnt, 0.5, 44100.0, scale);
+        if (fout.size() != cnt
+         || filterbank != SpectrumMapping::getFilterbank<double>(spec->getSum().size(), cnt, 44100.0, 0.5, scale)) {
+            return false;
+        }
+        for (size_t n = 0; n < cnt; ++n) {
+            auto weights = filterbank->getWeights(n);
+            double sum{}, norm{};
+            for (size_t i = 0; i < weights.size(); ++i) {
+                sum += weights[i] * spec->getSum()[filterbank->getFirst(n) + i];
+                norm += weights[i];
+            }
+            if (std::abs(sum / norm - fout[n]) > 1.0e-5 * std::max(sum / norm, 1.0e-3)) {
+                std::cout << "filterbank differs at " << n << " " << fout[n] << " expected " << sum / norm << std::endl;
+                return false;
+            }
+        }
+        auto peak = static_cast<size_t>(std::distance(fout.begin(), std::max_element(fout.begin(), fout.end())));
+        auto lower = SpectrumMapping::toScale(0.0, scale);
+        auto step = (SpectrumMapping::toScale(0.5 * 22050.0, scale) - lower) / static_cast<double>(cnt + 1u);
+        auto center = SpectrumMapping::fromScale(lower + step * static_cast<double>(peak + 1u), scale);
+        auto toneScale = SpectrumMapping::toScale(1000.0, scale);
+        std::cout << "filterbank peak " << peak << " center " << center << "Hz" << std::endl;
+        if (std::abs(SpectrumMapping::toScale(center, scale) - toneScale) > step) {
+            return false;
+        }
+    }
+    std::vector<double> a(1001u), b(1001u);
+    for (size_t i = 0; i < a.size(); ++i) {
+        a[i] = std::sin(static_cast<double>(i));
+        b[i] = std::cos(static_cast<double>(i) * 0.3);
+    }
+    auto expected = SpectrumKernel<double>::getDotKernel(SimdLevel::Scalar)(a.data(), b.data(), a.size());
+    for (auto level : {SimdLevel::Sse2, SimdLevel::Avx2}) {
+        if (auto kernel = SpectrumKernel<double>::getDotKernel(level)) {
+            if (std::abs(kernel(a.data(), b.data(), a.size()) - expected) > 1.0e-9) {
+                std::cout << "dot " << SpectrumKernel<double>::toId(level) << " differs" << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static bool
+check_constant_q()
+{
+    FftConstantQ<int16_t, double> constantQ{1u, 44100.0};
+    SinusSignal sinus;
+    auto data = sinus.generate(static_cast<size_t>(constantQ.getFftSize()) * 2u, 44100.0f / 440.0f);
+    // push in parts as it would be streamed
+    constexpr size_t part{4096u};
+    for (size_t pos = 0; pos < data.size(); pos += part) {
+        ChunkedArray<int16_t> chunk{1u};
+        data.for_each_segment(pos, std::min(pos + part, data.size()), [&chunk] (std::span<const int16_t> segment) {
+            chunk.add(segment, nullptr);
+        });
+        if (!constantQ.push(chunk)) {
+            return false;
+        }
+    }
+    auto& values = constantQ.getValues();
+    auto peak = static_cast<size_t>(std::distance(values.begin(), std::max_element(values.begin(), values.end())));
+    const double amplitude = sinus.getScale() * ChunkedArray<int16_t>::INPUT_SCALE;
+    std::cout << "constantQ bins " << constantQ.getBinCount()
+              << " fft " << constantQ.getFftSize()
+              << " kernel " << constantQ.getKernelSize()
+              << " peak " << peak << " " << constantQ.getFrequency(peak) << "Hz"
+              << " value " << values[peak] << " expected " << amplitude
+              << " time " << constantQ.getFrameTime() << "us" << std::endl;
+    if (peak != 36u     // A4 is 3 octaves above A1
+     || std::abs(values[peak] - amplitude) > 0.1 * amplitude
+     || values[peak - 2u] > 0.1 * values[peak]
+     || values[peak + 2u] > 0.1 * values[peak]
+     || constantQ.getKernelSize() == 0u
+     || constantQ.getKernelSize() >= constantQ.getBinCount() * (constantQ.getFftSize() / 2u + 1u) / 8u) {
+        return false;
+    }
+    std::vector<float> fout;
+    constantQ.adjust(fout, constantQ.getBinCount() / 2u);
+    if (fout.size() != constantQ.getBinCount() / 2u
+     || std::abs(fout[peak / 2u] - static_cast<float>(values[peak])) > 1.0e-6f) {
+        return false;
+    }
+    return true;
+}
+
+static bool
+check_level()
+{
+    SpectrumLevel<float> level;
+    std::vector<float> values{0.1f, 0.2f, 0.05f};
+    auto fixed = values;
+    level.process(fixed, 0.02);
+    if (fixed != values) {      // unchanged by default
+        return false;
+    }
+    level.setGain(LevelGain::Peak);
+    level.setTarget(4.0);
+    for (size_t i = 0; i < 10u; ++i) {
+        auto frame = values;
+        level.process(frame, 0.02);
+        if (std::abs(frame[1] - 4.0f) > 1.0e-5f) {
+            return false;
+        }
+    }
+    std::vector<float> loud{0.1f, 0.8f, 0.05f};
+    auto frame = loud;
+    level.process(frame, 0.02);
+    if (frame[1] > 4.0f) {      // no clipping while the attack follows
+        return false;
+    }
+    frame = loud;
+    level.process(frame, 1.0);
+    if (std::abs(level.getReference() - 0.8) > 0.01) {
+        return false;
+    }
+    std::vector<float> quiet{0.01f, 0.02f, 0.005f};
+    frame = quiet;
+    level.process(frame, 0.02);
+    if (level.getReference() < 0.7) {   // the release is slow
+        return false;
+    }
+    for (size_t i = 0; i < 10u; ++i) {
+        frame = quiet;
+        level.process(frame, 3.0);
+    }
+    if (std::abs(frame[1] - 4.0f) > 0.01f) {
+        return false;
+    }
+    level.setGain(LevelGain::Fixed);
+    level.setDecibel(true);
+    level.setRange(60.0);
+    std::vector<float> db{1.0f, 0.001f, std::pow(10.0f, -1.5f), 0.0f};
+    level.process(db, 0.02);
+    if (std::abs(db[0] - 4.0f) > 1.0e-5f
+     || std::abs(db[1]) > 1.0e-5f
+     || std::abs(db[2] - 2.0f) > 1.0e-4f
+     || db[3] != 0.0f) {
+        std::cout << "level dB " << db[0] << " " << db[1] << " " << db[2] << " " << db[3] << std::endl;
+        return false;
+    }
+    // values in display units, the reference at the target keeps the top of the display
+    level.setReference(4.0);
+    std::vector<float> display{4.0f, 4.0f * std::pow(10.0f, -1.5f)};
+    level.process(display, 0.02);
+    if (std::abs(display[0] - 4.0f) > 1.0e-5f
+     || std::abs(display[1] - 2.0f) > 1.0e-4f) {
+        std::cout << "level dB display " << display[0] << " " << display[1] << std::endl;
+        return false;
+    }
+    SpectrumLevel<double> percentile;
+    percentile.setGain(LevelGain::Percentile);
+    percentile.setPercentile(0.5);
+    std::vector<double> bins(101u);
+    for (size_t i = 0; i < bins.size(); ++i) {
+        bins[i] = static_cast<double>(i) / 100.0;
+    }
+    percentile.process(bins, 0.02);
+    if (std::abs(percentile.getReference() - 0.5) > 1.0e-9
+     || bins.back() != 1.0) {   // the loudest bins are limited to the target
+        return false;
+    }
+    return true;
+}
+
+static bool
+check_smoothing()
+{
+    SpectrumSmoothing<float> smoothing;
+    std::vector<float> values{0.0f, 1.0f};
+    auto frame = values;
+    smoothing.process(frame, 0.02);
+    if (frame != values) {      // off by default
+        return false;
+    }
+    smoothing.setMode(SmoothingMode::Smooth);
+    smoothing.setAttack(0.1);
+    smoothing.setRelease(1.0);
+    smoothing.resize(values.size());
+    smoothing.process(frame, 0.02);     // the first frame starts the state
+    std::vector<float> step{1.0f, 0.0f};
+    frame = step;
+    smoothing.process(frame, 0.1);
+    const float rise = 1.0f - std::exp(-1.0f);
+    if (std::abs(frame[0] - rise) > 1.0e-5f
+     || std::abs(frame[1] - std::exp(-0.1f)) > 1.0e-5f) {
+        std::cout << "smoothing " << frame[0] << " " << frame[1] << std::endl;
+        return false;
+    }
+    smoothing.setMode(SmoothingMode::PeakHold);
+    smoothing.setRelease(0.01);     // only the held peak stays
+    smoothing.setHold(0.5);
+    smoothing.setFall(0.2);
+    std::vector<float> impulse{0.0f, 0.0f, 1.0f};   // the new size is handled
+    frame = impulse;
+    smoothing.process(frame, 0.02);
+    std::vector<float> silence(impulse.size());
+    for (size_t i = 0; i < 4u; ++i) {   // the peak is kept during the hold
+        frame = silence;
+        smoothing.process(frame, 0.1);
+        if (frame[2] != 1.0f || frame[0] != 0.0f) {
+            return false;
+        }
+    }
+    frame = silence;
+    smoothing.process(frame, 0.2);
+    if (std::abs(frame[2] - std::exp(-1.0f)) > 1.0e-5f) {
+        std::cout << "peak hold " << frame[2] << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// the stream has to analyze the same windows as one execute,
+//   regardless of how the input is split up
+static bool
+check_stream()
+{
+    constexpr uint32_t windowSize{512u};
+    constexpr uint32_t hopSize{256u};
+    constexpr size_t hops{400u};
+    const size_t frames = hops * hopSize + windowSize + 2u;    // execute uses the same windows for this length
+    SinusSignal sinus;
+    auto data = sinus.generate(frames, 44100.0f / 1000.0f);
+    FftEngine<double> engine{windowSize, hopSize};
+    auto spec = engine.execute(data);
+
+    for (uint32_t streamHop : {hopSize, windowSize * 2u}) {
+        FftStream<int16_t, double> stream{1u, windowSize, streamHop};
+        std::vector<double> sum(windowSize / 2u + 1u, 0.0);
+        size_t count{};
+        stream.setFrameListener([&] (const SpectrumBase<double>& frame) {
+            auto frameSum = frame.getValues();
+            for (size_t i = 0; i < sum.size(); ++i) {
+                sum[i] += frameSum[i];
+            }
+            ++count;
+        });
+        size_t pos{};
+        for (size_t n = 0; pos < frames; ++n) {
+            size_t len = std::min(frames - pos, std::array<size_t, 4>{441u, 1000u, 37u, 4096u}[n % 4u]);
+            stream.push(data.slice(pos, pos + len));
+            pos += len;
+        }
+        size_t expected = (frames - windowSize) / streamHop + 1u;
+        std::cout << "stream hop " << streamHop
+                  << " windows " << count
+                  << " expected " << expected
+                  << " pending " << stream.getPending() << std::endl;
+        if (count != expected
+         || stream.getWindows() != expected) {
+            return false;
+        }
+        if (streamHop == hopSize) {
+            auto max = spec->getMax();
+            for (size_t i = 0; i < sum.size(); ++i) {
+                if (std::abs(sum[i] / static_cast<double>(count) - spec->getSum()[i]) / max > 1.0e-9) {
+                    std::cout << "stream differs at " << i
+                              << " stream " << sum[i] / static_cast<double>(count)
+                              << " execute " << spec->getSum()[i] << std::endl;
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+// the channel access shall give the same samples as the index,
+//   including stereo frames that are split between chunks
+static bool
+check_channels()
+{
+    ChunkedArray<int16_t> stereo{2u};
+    ChunkedArray<int16_t> mono{1u};     // the mid signal
+    int16_t value{};
+    for (size_t part : {3u, 7u, 5u, 1u, 9u, 11u, 2u, 13u, 1u, 4u}) {   // odd sizes split frames
+        auto chunk = std::make_shared<std::vector<int16_t>>();
+        for (size_t i = 0; i < part; ++i) {
+            chunk->push_back(static_cast<int16_t>(((value * 37) % 100 - 50) * 2));  // even, so mid is exact
+            ++value;
+        }
+        stereo.add(chunk);
+    }
+    const size_t frames = stereo.getFrames();
+    auto monoData = std::make_shared<std::vector<int16_t>>();
+    for (size_t n = 0; n < frames; ++n) {
+        monoData->push_back(static_cast<int16_t>((stereo[2u * n] + stereo[2u * n + 1u]) / 2));
+    }
+    mono.add(monoData);
+    for (size_t pos : std::initializer_list<size_t>{0u, 1u, 2u, 5u, frames - 3u}) {
+        const size_t count = frames - pos + 2u;     // the end is zero filled
+        std::vector<double> dst(count);
+        for (uint32_t ch = 0; ch < 2u; ++ch) {
+            auto copied = stereo.copy_channel(pos, count, ch, dst.data(), 0.5);
+            auto view = stereo.channel(ch);
+            if (copied != frames - pos || view.size() != frames) {
+                return false;
+            }
+            for (size_t n = 0; n < count; ++n) {
+                const double expected = pos + n < frames ? stereo[2u * (pos + n) + ch] * 0.5 : 0.0;
+                if (dst[n] != expected
+                 || (pos + n < frames && view[pos + n] != stereo[2u * (pos + n) + ch])) {
+                    std::cout << "channel " << ch << " differs at " << pos + n << std::endl;
+                    return false;
+                }
+            }
+        }
+        std::vector<double> mid(count, -1.0), side(count, -1.0);
+        auto copied = stereo.downmix_mid_side(pos, frames - pos, mid.data(), side.data(), 1.0);
+        if (copied != frames - pos) {
+            return false;
+        }
+        for (size_t n = 0; n < frames - pos; ++n) {
+            const double left = stereo[2u * (pos + n)];
+            const double right = stereo[2u * (pos + n) + 1u];
+            if (mid[n] != (left + right) * 0.5
+             || side[n] != (left - right) * 0.5) {
+                std::cout << "mid/side differs at " << pos + n << std::endl;
+                return false;
+            }
+        }
+    }
+    // the analysis of the mid signal shall match the mono downmix
+    FftEngine<double> engine{16u};
+    auto expected = engine.execute(mono);
+    auto spec = engine.execute(stereo, FftEngine<double>::CHANNEL_MID);
+    for (size_t i = 0; i < expected->getSum().size(); ++i) {
+        if (std::abs(spec->getSum()[i] - expected->getSum()[i]) > 1.0e-9) {
+            std::cout << "mid spectrum differs at " << i << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// compare the samples by index and by copy_window
+static bool
+same_samples(const ChunkedArray<int16_t>& array, const std::vector<int16_t>& expected)
+{
+    if (array.size() != expected.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < expected.size(); ++i) {
+        if (array[i] != expected[i]) {
+            std::cout << "coalesced differs at " << i << std::endl;
+            return false;
+        }
+    }
+    for (size_t pos : {0u, 1u, 15u, 16u, 33u}) {    // across the blocks
+        std::vector<double> window(40u);
+        array.copy_window(pos, window.size(), window.data(), 1.0);
+        for (size_t n = 0; n < window.size(); ++n) {
+            const double value = pos + n < expected.size() ? expected[pos + n] : 0.0;
+            if (window[n] != value) {
+                std::cout << "coalesced window differs at " << pos + n << std::endl;
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// merging small fragments into blocks shall keep the samples,
+//   also for copies and slices that share a block that is not full
+static bool
+check_coalesce()
+{
+    ChunkedArray<int16_t> plain{1u};
+    ChunkedArray<int16_t> coalesced{1u};
+    coalesced.setCoalesce(16u);
+    std::vector<int16_t> expected;
+    int16_t value{};
+    auto addFragment = [&] (size_t size) {
+        auto fragment = std::make_shared<std::vector<int16_t>>();
+        for (size_t i = 0; i < size; ++i) {
+            fragment->push_back(value++);
+        }
+        plain.add(fragment);
+        coalesced.add(fragment);
+        expected.insert(expected.end(), fragment->begin(), fragment->end());
+    };
+    for (size_t size : {3u, 5u, 7u, 2u, 20u, 1u, 6u, 4u, 9u}) {     // 20 is added as chunk
+        addFragment(size);
+    }
+    auto statistics = coalesced.getStatistics();
+    if (!same_samples(plain, expected)
+     || !same_samples(coalesced, expected)
+     || statistics.fragments != 9u
+     || statistics.coalesced != 8u
+     || statistics.chunks >= plain.getStatistics().chunks) {
+        return false;
+    }
+    // the open block is shared now, so the following shall not extend it
+    auto copy = coalesced;
+    auto slice = coalesced.slice(10u, coalesced.size());
+    auto copyExpected = expected;
+    std::vector<int16_t> sliceExpected(expected.begin() + 10, expected.end());
+    addFragment(2u);
+    addFragment(5u);
+    if (!same_samples(coalesced, expected)
+     || !same_samples(copy, copyExpected)
+     || !same_samples(slice, sliceExpected)) {
+        return false;
+    }
+    // and the copy shall not extend the block of the original
+    auto fragment = std::make_shared<std::vector<int16_t>>(3u, static_cast<int16_t>(-1));
+    copy.add(fragment);
+    copyExpected.insert(copyExpected.end(), fragment->begin(), fragment->end());
+    addFragment(3u);
+    if (!same_samples(coalesced, expected)
+     || !same_samples(copy, copyExpected)) {
+        return false;
+    }
+    return true;
+}
+
+// measured planning has to give the same values and keep the wisdom
+// sizes that are not a multiple of 4 need padded batch slots to keep the fftw alignment
+static bool
+check_alignment(const ChunkedArray<int16_t>& data)
+{
+    for (uint32_t size : {6u, 10u, 30u}) {
+        FftBuffers<float> buffers{size};
+        for (uint32_t slot = 0; slot < FftSetup<float>::BATCH_WINDOWS; ++slot) {
+            if (reinterpret_cast<uintptr_t>(buffers.getInput(slot)) % 16u != 0u
+             || reinterpret_cast<uintptr_t>(buffers.getResult(slot)) % 16u != 0u) {
+                std::cout << "alignment size " << size << " slot " << slot << std::endl;
+                return false;
+            }
+        }
+        FftEngine<double> engine{size, size / 2u};
+        FftEngine<float> enginef{size, size / 2u};
+        auto spec = engine.execute(data);
+        auto specf = enginef.execute(data);
+        auto max = spec->getMax();
+        for (size_t i = 0; i < spec->getSum().size(); ++i) {
+            if (std::abs(spec->getSum()[i] - specf->getSum()[i]) / max > 1.0e-4) {
+                std::cout << "alignment size " << size << " differs at " << i
+                          << " double " << spec->getSum()[i]
+                          << " float " << specf->getSum()[i] << std::endl;
+                return false;
+            }
+        }
+    }
+    try {
+        FftEngine<float> empty{0u};
+        std::cout << "alignment size 0 accepted" << std::endl;
+        return false;
+    }
+    catch (const std::runtime_error&) {
+    }
+    return true;
+}
+
+static bool
+check_planning(const ChunkedArray<int16_t>& data)
+{
+    auto cache = std::filesystem::temp_directory_path() / "glscene-fft-test";
+    std::filesystem::remove_all(cache);
+    setenv("XDG_CACHE_HOME", cache.c_str(), 1);
+    Fft512 fftEstimate;
+    auto specEstimate = fftEstimate.execute(data);
+    FftPlanner::setPlanning(FftPlanning::Measure);
+    std::vector<double> sum;
+    {
+        Fft512 fftMeasure;
+        sum = fftMeasure.execute(data)->getVector();
+    }
+    auto start = std::chrono::steady_clock::now();
+    Fft512 fftWisdom;       // this plan shall come from the wisdom
+    auto finish = std::chrono::steady_clock::now();
+    FftPlanner::setPlanning(FftPlanning::Estimate);
+    auto wisdomFile = FftPlanner::getWisdomFile();
+    bool exists = std::filesystem::exists(wisdomFile);
+    std::cout << "planning wisdom " << wisdomFile
+              << " exists " << std::boolalpha << exists
+              << " replan " << std::chrono::duration_cast<std::chrono::duration<double>>(finish - start).count() << std::endl;
+    std::filesystem::remove_all(cache);
+    auto& sumEstimate = specEstimate->getSum();
+    auto max = std::ranges::max(sumEstimate);
+    for (size_t i = 0; i < sum.size(); ++i) {
+        if (std::abs(sum[i] - sumEstimate[i]) / max > 1.0e-9) {
+            std::cout << "planning differs at " << i
+                      << " measure " << sum[i]
+                      << " estimate " << sumEstimate[i] << std::endl;
+            return false;
+        }
+    }
+    return exists;
+}
+
 static bool
 check_alsa(const std::string& name, ChunkedArray<int16_t>& data)
 {
@@ -248,6 +1193,85 @@ int main(int argc, char** argv)
         }
     }
 
+    {
+        SinusSignal sinus;
+        auto data = sinus.generate(44100u * 10u, 44100.0f / 1000.0f);
+        Fft512 fft512;
+        Fft512n256 fft512n256;
+        Fft2k fft2k;
+        Fft2k1k fft2k1k;
+        if (!check_r2c<512u>(&fft512, "Fft512", data)
+         || !check_r2c<512u>(&fft512n256, "Fft512n256", data)
+         || !check_r2c<2048u>(&fft2k, "Fft2k", data)
+         || !check_r2c<2048u>(&fft2k1k, "Fft2k1k", data)) {
+            return 5;
+        }
+        if (!check_planning(data)) {
+            return 6;
+        }
+        if (!check_batched<512u>(&fft512n256, "Fft512n256")
+         || !check_batched<2048u>(&fft2k, "Fft2k")) {
+            return 7;
+        }
+        Fft512f fft512f;
+        Fft2kf fft2kf;
+        if (!check_precision<512u>(&fft512, &fft512f, "Fft512f", data)
+         || !check_precision<2048u>(&fft2k, &fft2kf, "Fft2kf", data)) {
+            return 8;
+        }
+        if (!check_engine(&fft512, data)) {
+            return 9;
+        }
+        if (!check_stream()) {
+            return 10;
+        }
+        if (!check_parallel()) {
+            return 11;
+        }
+        if (!check_snapshot()) {
+            return 12;
+        }
+        std::cout << "kernel " << SpectrumKernel<double>::toId(SpectrumKernel<double>::getLevel()) << std::endl;
+        if (!check_kernel<double>(1.0e-12)
+         || !check_kernel<float>(1.0e-5f)) {
+            return 13;
+        }
+        if (!check_window<HammingPolicy>(FftWindowType::Hamming)
+         || !check_window<HannPolicy>(FftWindowType::Hann)
+         || !check_window<BlackmanHarrisPolicy>(FftWindowType::BlackmanHarris)
+         || !check_window<FlatTopPolicy>(FftWindowType::FlatTop)
+         || !check_window<KaiserPolicy<>>(FftWindowType::Kaiser)) {
+            return 14;
+        }
+        if (!check_mapping(&fft512, &fft2k, data)) {
+            return 15;
+        }
+        if (!check_into(&fft512, data)) {
+            return 16;
+        }
+        if (!check_filterbank(&fft2k)) {
+            return 17;
+        }
+        if (!check_constant_q()) {
+            return 18;
+        }
+        if (!check_level()) {
+            return 19;
+        }
+        if (!check_smoothing()) {
+            return 20;
+        }
+        if (!check_channels()) {
+            return 21;
+        }
+        if (!check_coalesce()) {
+            return 22;
+        }
+        if (!check_alignment(data)) {
+            return 23;
+        }
+    }
+
     auto start = std::chrono::steady_clock::now();
     auto fac = factorial(6);   // 499999500000
     auto finish = std::chrono::steady_clock::now();
@@ -52,18 +52,19 @@ TestApp::getResult()
 {
     m_pulseOut->drain();
     m_pulseIn->disconnect();
-    auto data = m_pulseIn->read();
+    auto& data = m_pulseIn->read();
     printf("TestApp::getResult got %ld samples\n", data.size());
     int16_t min{std::numeric_limits<int16_t>::max()},max{std::numeric_limits<int16_t>::min()};
     int64_t avg{},cnt{};
     auto start = std::chrono::steady_clock::now();
-    for (size_t i = 0; i < data.size(); ++i) {
-        auto v = data.operator [](i);
-        min = std::min(min, v);
-        max = std::max(max, v);
-        avg += v;
-        ++cnt;
-    }
+    data.for_each_segment(0, data.size(), [&] (std::span<const int16_t> segment) {
+        for (auto v : segment) {
+            min = std::min(min, v);
+            max = std::max(max, v);
+            avg += v;
+        }
+        cnt += static_cast<int64_t>(segment.size());
+    });
     auto finish = std::chrono::steady_clock::now();
     double elapsed_seconds = std::chrono::duration_cast<std::chrono::duration<double>>(finish - start).count();
     std::cout << "duration " << elapsed_seconds << std::endl;
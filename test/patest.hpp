@@ -22,10 +22,13 @@
 #include <glibmm.h>
 #include <giomm.h>
 #include <memory>
+#include <cstdint>
 
 namespace psc::snd
 {
-class PulseIn;
+template<typename T>
+class PulseInput;
+using PulseIn = PulseInput<int16_t>;
 class PulseOut;
 }
 
@@ -0,0 +1,223 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+#include "MappedFile.hpp"
+#include "Fft.hpp"
+
+static void
+writeLe(std::ofstream& out, uint32_t val, size_t bytes)
+{
+    for (size_t i = 0; i < bytes; ++i) {
+        out.put(static_cast<char>((val >> (i * 8)) & 0xffu));
+    }
+}
+
+// a stereo wav with a different frequency for each channel
+static std::vector<int16_t>
+writeWav(const std::filesystem::path& path, size_t frames)
+{
+    std::vector<int16_t> samples;
+    samples.reserve(frames * 2);
+    for (size_t i = 0; i < frames; ++i) {
+        samples.push_back(static_cast<int16_t>(std::sin(static_cast<double>(i) * 2.0 * M_PI / 32.0) * 10000.0));
+        samples.push_back(static_cast<int16_t>(std::sin(static_cast<double>(i) * 2.0 * M_PI / 8.0) * 10000.0));
+    }
+    const uint32_t dataSize = static_cast<uint32_t>(samples.size() * sizeof(int16_t));
+    std::ofstream out(path, std::ios::binary);
+    out.write("RIFF", 4);
+    writeLe(out, 36u + 8u + dataSize, 4);   // includes a list chunk to skip
+    out.write("WAVEfmt ", 8);
+    writeLe(out, 16u, 4);
+    writeLe(out, 1u, 2);            // pcm
+    writeLe(out, 2u, 2);            // channels
+    writeLe(out, 44100u, 4);
+    writeLe(out, 44100u * 4u, 4);
+    writeLe(out, 4u, 2);
+    writeLe(out, 16u, 2);
+    out.write("LIST", 4);
+    writeLe(out, 0u, 4);
+    out.write("data", 4);
+    writeLe(out, dataSize, 4);
+    out.write(reinterpret_cast<const char*>(samples.data()), dataSize);
+    return samples;
+}
+
+// a float wav as written by e.g. sox, the fmt chunk has 18 bytes (with cbSize)
+//   and a fact chunk follows, so the data starts at 58 (not aligned for float)
+static std::vector<float>
+writeFloatWav(const std::filesystem::path& path, size_t frames)
+{
+    std::vector<float> samples;
+    samples.reserve(frames);
+    for (size_t i = 0; i < frames; ++i) {
+        samples.push_back(static_cast<float>(std::sin(static_cast<double>(i) * 2.0 * M_PI / 16.0) * 0.5));
+    }
+    const uint32_t dataSize = static_cast<uint32_t>(samples.size() * sizeof(float));
+    std::ofstream out(path, std::ios::binary);
+    out.write("RIFF", 4);
+    writeLe(out, 4u + 8u + 18u + 8u + 4u + 8u + dataSize, 4);
+    out.write("WAVEfmt ", 8);
+    writeLe(out, 18u, 4);
+    writeLe(out, 3u, 2);            // ieee float
+    writeLe(out, 1u, 2);            // channels
+    writeLe(out, 44100u, 4);
+    writeLe(out, 44100u * 4u, 4);
+    writeLe(out, 4u, 2);
+    writeLe(out, 32u, 2);
+    writeLe(out, 0u, 2);            // cbSize
+    out.write("fact", 4);
+    writeLe(out, 4u, 4);
+    writeLe(out, static_cast<uint32_t>(frames), 4);
+    out.write("data", 4);
+    writeLe(out, dataSize, 4);
+    out.write(reinterpret_cast<const char*>(samples.data()), dataSize);
+    return samples;
+}
+
+template<uint32_t windowSize>
+static size_t
+peakBin(const std::shared_ptr<Spectrum<windowSize>>& spec)
+{
+    auto& sum = spec->getSum();
+    return static_cast<size_t>(std::distance(sum.begin(), std::ranges::max_element(sum)));
+}
+
+static bool
+check_wav()
+{
+    auto path = std::filesystem::temp_directory_path() / "glscene_pcm_test.wav";
+    auto samples = writeWav(path, 44100u * 4u);
+    bool ret{true};
+    try {
+        PcmFile<int16_t> pcm(path.string());
+        auto data = pcm.getArray(1000u);    // a odd size, so chunks need to be adjusted to frames
+        if (pcm.getChannels() != 2 || pcm.getSampleRate() != 44100u || data.size() != samples.size()) {
+            std::cout << "wav channels " << pcm.getChannels()
+                      << " rate " << pcm.getSampleRate()
+                      << " size " << data.size() << " expected " << samples.size() << std::endl;
+            ret = false;
+        }
+        for (size_t i = 0; ret && i < samples.size(); i += 997u) {
+            if (data[i] != samples[i]) {
+                std::cout << "wav sample " << i << " " << data[i] << " expected " << samples[i] << std::endl;
+                ret = false;
+            }
+        }
+        Fft512 fft;
+        auto left = peakBin(fft.execute(data, 0));
+        auto right = peakBin(fft.execute(data, 1));
+        std::cout << "wav peak left " << left << " right " << right << std::endl;
+        if (left != 512u / 32u || right != 512u / 8u) {
+            ret = false;
+        }
+        // the last second, begin at a frame but within a chunk
+        const size_t begin{data.size() - 44100u * 2u};
+        auto last = data.slice(begin, data.size());
+        if (last.size() != data.size() - begin || last[0] != data[begin] || last[last.size() - 1] != data[data.size() - 1]) {
+            std::cout << "slice size " << last.size() << " " << last[0] << " expected " << data[begin] << std::endl;
+            ret = false;
+        }
+        auto lastLeft = peakBin(fft.execute(last, 0));
+        if (lastLeft != left) {
+            std::cout << "slice peak left " << lastLeft << std::endl;
+            ret = false;
+        }
+        pcm.release(data.size());
+    }
+    catch (const PcmException& exc) {
+        std::cout << "wav " << exc.what() << std::endl;
+        ret = false;
+    }
+    std::filesystem::remove(path);
+    return ret;
+}
+
+static bool
+check_float_wav()
+{
+    auto path = std::filesystem::temp_directory_path() / "glscene_pcm_test_float.wav";
+    auto samples = writeFloatWav(path, 44100u);
+    bool ret{true};
+    try {
+        PcmFile<float> pcm(path.string());
+        auto data = pcm.getArray(1000u);
+        if (pcm.isMapped()      // the data at 58 needs the copy
+         || pcm.getChannels() != 1 || pcm.getSampleRate() != 44100u || data.size() != samples.size()) {
+            std::cout << "float wav mapped " << pcm.isMapped()
+                      << " channels " << pcm.getChannels()
+                      << " size " << data.size() << " expected " << samples.size() << std::endl;
+            ret = false;
+        }
+        for (size_t i = 0; ret && i < samples.size(); ++i) {
+            if (data[i] != samples[i]) {
+                std::cout << "float wav sample " << i << " " << data[i] << " expected " << samples[i] << std::endl;
+                ret = false;
+            }
+        }
+        Fft512 fft;
+        auto peak = peakBin(fft.execute(data));
+        if (peak != 512u / 16u) {
+            std::cout << "float wav peak " << peak << std::endl;
+            ret = false;
+        }
+    }
+    catch (const PcmException& exc) {
+        std::cout << "float wav " << exc.what() << std::endl;
+        ret = false;
+    }
+    std::filesystem::remove(path);
+    return ret;
+}
+
+static bool
+check_format()
+{
+    auto path = std::filesystem::temp_directory_path() / "glscene_pcm_test_fmt.wav";
+    writeWav(path, 100u);
+    bool ret{false};
+    try {
+        PcmFile<float> pcm(path.string());
+        std::cout << "format expected exception for int16 as float" << std::endl;
+    }
+    catch (const PcmException& exc) {
+        ret = true;
+    }
+    std::filesystem::remove(path);
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    if (!check_wav()) {
+        return 1;
+    }
+    if (!check_format()) {
+        return 2;
+    }
+    if (!check_float_wav()) {
+        return 3;
+    }
+    return 0;
+}
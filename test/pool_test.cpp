@@ -0,0 +1,166 @@
+/* -*- Mode: c++; c-basic-offset: 4; tab-width: 4; coding: utf-8; -*-  */
+/*
+ * Copyright (C) 2025 RPf
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <algorithm>
+
+#include "BufferPool.hpp"
+
+// the pool shall hand out its buffers again when they were released,
+//   and count the requests it could not serve
+static bool
+check_pool()
+{
+    BufferPool<int16_t> pool{2u, 8u};
+    auto first = pool.acquire(4u);
+    auto second = pool.acquire(4u);
+    if (!first || !second
+     || first->size() != 4u
+     || first->capacity() < 8u
+     || pool.getMisses() != 0u       // the pool is allocated up front
+     || pool.getHits() != 2u
+     || pool.getHighWater() != 2u) {
+        std::cout << "pool fill misses " << pool.getMisses() << " high water " << pool.getHighWater() << std::endl;
+        return false;
+    }
+    auto none = pool.acquire(4u);   // all in use, nothing is allocated
+    if (none
+     || pool.getMisses() != 1u
+     || pool.getHighWater() != 2u) {
+        std::cout << "pool exhausted misses " << pool.getMisses() << " high water " << pool.getHighWater() << std::endl;
+        return false;
+    }
+    auto buffer = first.get();
+    auto data = first->data();
+    first.reset();
+    auto reused = pool.acquire(6u);
+    if (reused.get() != buffer
+     || reused->data() != data          // no new allocation
+     || reused->size() != 6u
+     || pool.getHits() != 3u) {
+        std::cout << "pool not reused hits " << pool.getHits() << std::endl;
+        return false;
+    }
+    // a copy (e.g. held by a ChunkedArray) keeps the buffer in use
+    auto held = second;
+    second.reset();
+    auto next = pool.acquire(4u);
+    if (next
+     || pool.getMisses() != 2u) {
+        return false;
+    }
+    held.reset();
+    next = pool.acquire(4u);
+    if (!next
+     || pool.getHits() != 4u
+     || pool.getHighWater() != 2u) {
+        std::cout << "pool release hits " << pool.getHits() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// the queue shall keep the order and refuse buffers when full
+static bool
+check_queue()
+{
+    BufferQueue<int16_t> queue{2u};
+    auto first = std::make_shared<std::vector<int16_t>>(1u, 1);
+    auto second = std::make_shared<std::vector<int16_t>>(1u, 2);
+    auto third = std::make_shared<std::vector<int16_t>>(1u, 3);
+    if (!queue.push(first)
+     || !queue.push(second)
+     || queue.push(third)
+     || !third) {                   // stays with the caller
+        std::cout << "queue full not detected" << std::endl;
+        return false;
+    }
+    for (int16_t expected = 1; expected <= 8; ++expected) {
+        auto next = queue.pop();
+        if (!next || next->front() != expected) {
+            std::cout << "queue order at " << expected << std::endl;
+            return false;
+        }
+        auto more = std::make_shared<std::vector<int16_t>>(1u, static_cast<int16_t>(expected + 2));
+        queue.push(more);   // wraps the ring
+    }
+    queue.pop();
+    queue.pop();
+    if (queue.pop()) {
+        std::cout << "queue not empty" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// one thread acquiring and pushing (as the audio callback), one popping and releasing
+static bool
+check_handoff()
+{
+    constexpr int16_t count{20000};
+    BufferPool<int16_t> pool{4u, 8u};
+    BufferQueue<int16_t> queue{pool.getCapacity()};
+    std::thread producer([&] {
+        for (int16_t i = 0; i < count; ) {
+            auto buffer = pool.acquire(8u);
+            if (!buffer) {
+                std::this_thread::yield();
+                continue;
+            }
+            std::fill(buffer->begin(), buffer->end(), i);
+            if (!queue.push(buffer)) {
+                std::this_thread::yield();
+                continue;               // the buffer is released, try again
+            }
+            ++i;
+        }
+    });
+    bool ret{true};
+    for (int16_t expected = 0; expected < count; ) {
+        auto next = queue.pop();
+        if (!next) {
+            std::this_thread::yield();
+            continue;
+        }
+        if (next->size() != 8u
+         || std::ranges::any_of(*next, [expected] (int16_t val) { return val != expected; })) {
+            std::cout << "handoff content at " << expected << std::endl;
+            ret = false;
+        }
+        ++expected;
+    }
+    producer.join();
+    return ret;
+}
+
+int main(int argc, char** argv)
+{
+    if (!check_pool()) {
+        return 1;
+    }
+    if (!check_queue()) {
+        return 2;
+    }
+    if (!check_handoff()) {
+        return 3;
+    }
+    return 0;
+}